@@ -6,6 +6,7 @@
 #include "Components/BoxComponent.h"
 #include "Components/WidgetComponent.h"
 #include "ShooterCharacter.h"
+#include "PickupStoreSubsystem.h"
 
 
 AAmmo::AAmmo()
@@ -19,6 +20,7 @@ AAmmo::AAmmo()
 
 	AmmoCollisionSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AmmoCollisionSphere"));
 	AmmoCollisionSphere->SetupAttachment(GetRootComponent());
+	AmmoCollisionSphere->SetCollisionProfileName(PickupAreaProfileName);
 }
 
 void AAmmo::BeginPlay()
@@ -28,11 +30,6 @@ void AAmmo::BeginPlay()
 	AmmoCollisionSphere->OnComponentBeginOverlap.AddDynamic(this, &AAmmo::AmmoCollisionSphereOverlap);
 }
 
-void AAmmo::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
 void AAmmo::SetItemProperties(EItemState State)
 {
 	Super::SetItemProperties(State);
@@ -98,3 +95,19 @@ void AAmmo::DisableCustomDepth()
 	AmmoMesh->SetRenderCustomDepth(false);
 }
 
+UStaticMesh* AAmmo::GetPickupProxyMesh() const
+{
+	return AmmoMesh->GetStaticMesh();
+}
+
+void AAmmo::WritePickupRecord(FPickupRecord& Record) const
+{
+	Super::WritePickupRecord(Record);
+	Record.AmmoType = AmmoType;
+}
+
+void AAmmo::ReadPickupRecord(const FPickupRecord& Record)
+{
+	AmmoType = Record.AmmoType;
+	Super::ReadPickupRecord(Record);
+}
@@ -17,7 +17,6 @@ class BADASSSHOOTER_API AAmmo : public AItem
 
 public:
 	AAmmo();
-	virtual void Tick(float DeltaTime) override;
 
 protected:
 	virtual void BeginPlay() override;
@@ -54,5 +53,10 @@ public:
 
 	virtual void EnableCustomDepth() override;
 	virtual void DisableCustomDepth() override;
+
+	/* Pickup store hooks (the ammo mesh is the proxy, the ammo type is part of the record) */
+	virtual UStaticMesh* GetPickupProxyMesh() const override;
+	virtual void WritePickupRecord(FPickupRecord& Record) const override;
+	virtual void ReadPickupRecord(const FPickupRecord& Record) override;
 	
 };
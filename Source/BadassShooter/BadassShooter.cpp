@@ -4,3 +4,23 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, BadassShooter, "BadassShooter" );
+
+DEFINE_LOG_CATEGORY(LogBadassShooter);
+
+DEFINE_STAT(STAT_TraceForItems);
+DEFINE_STAT(STAT_TraceUnderCrosshairs);
+DEFINE_STAT(STAT_GetBeamEndLocation);
+DEFINE_STAT(STAT_GetFoostepsSurface);
+
+DEFINE_STAT(STAT_ItemFocusQueries);
+DEFINE_STAT(STAT_CrosshairQueries);
+DEFINE_STAT(STAT_BeamQueries);
+DEFINE_STAT(STAT_FootstepQueries);
+DEFINE_STAT(STAT_DeferredQueries);
+DEFINE_STAT(STAT_DroppedQueries);
+
+DEFINE_STAT(STAT_CameraFOVUpdates);
+DEFINE_STAT(STAT_LookRateUpdates);
+DEFINE_STAT(STAT_CrosshairSpreadUpdates);
+DEFINE_STAT(STAT_ItemTraceUpdates);
+DEFINE_STAT(STAT_CapsuleHeightUpdates);
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 #define EPS_Metal EPhysicalSurface::SurfaceType1
 #define EPS_Stone EPhysicalSurface::SurfaceType2
@@ -10,4 +11,31 @@
 #define EPS_Grass EPhysicalSurface::SurfaceType4
 #define EPS_Water EPhysicalSurface::SurfaceType5
 
+#define ECC_Pickup		ECollisionChannel::ECC_GameTraceChannel1
+#define ECC_WeaponFire	ECollisionChannel::ECC_GameTraceChannel2
 
+DECLARE_LOG_CATEGORY_EXTERN(LogBadassShooter, Log, All);
+
+/* Scene queries issued by gameplay code (stat ShooterTraces) */
+DECLARE_STATS_GROUP(TEXT("ShooterTraces"), STATGROUP_ShooterTraces, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TraceForItems"), STAT_TraceForItems, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TraceUnderCrosshairs"), STAT_TraceUnderCrosshairs, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetBeamEndLocation"), STAT_GetBeamEndLocation, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetFoostepsSurface"), STAT_GetFoostepsSurface, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Item Focus Queries"), STAT_ItemFocusQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crosshair Queries"), STAT_CrosshairQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Beam Queries"), STAT_BeamQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Queries"), STAT_FootstepQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Deferred Queries"), STAT_DeferredQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Dropped Queries"), STAT_DroppedQueries, STATGROUP_ShooterTraces, BADASSSHOOTER_API);
+
+/* How often each per frame path of the shooter character actually ran (stat ShooterCharacter) */
+DECLARE_STATS_GROUP(TEXT("ShooterCharacter"), STATGROUP_ShooterCharacter, STATCAT_Advanced);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Camera FOV Updates"), STAT_CameraFOVUpdates, STATGROUP_ShooterCharacter, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Look Rate Updates"), STAT_LookRateUpdates, STATGROUP_ShooterCharacter, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Crosshair Spread Updates"), STAT_CrosshairSpreadUpdates, STATGROUP_ShooterCharacter, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Item Trace Updates"), STAT_ItemTraceUpdates, STATGROUP_ShooterCharacter, BADASSSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Capsule Height Updates"), STAT_CapsuleHeightUpdates, STATGROUP_ShooterCharacter, BADASSSHOOTER_API);
@@ -2,20 +2,40 @@
 
 
 #include "Enemy.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
 
 // Sets default values
-AEnemy::AEnemy()
+AEnemy::AEnemy(const FObjectInitializer& ObjectInitializer) :
+	Super(ObjectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName))
 {
  	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	// Animation is ticked by the budget allocator (a.Budget.BudgetMs) at a rate picked from CalculateAnimSignificance
+	if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+	{
+		BudgetedMesh->SetAutoRegisterWithBudgetAllocator(true);
+		BudgetedMesh->SetAutoCalculateSignificance(true);
+	}
+
+	// Update rate optimizations take over when the budget allocator is off (a.Budget.Enabled 0)
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
+	// Off screen enemies only tick montages so attacks and their notifies still play out
+	GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
 }
 
 // Called when the game starts or when spawned
 void AEnemy::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+	{
+		BudgetedMesh->OnCalculateSignificance().BindUObject(this, &AEnemy::CalculateAnimSignificance);
+	}
 }
 
 // Called every frame
@@ -32,3 +52,31 @@ void AEnemy::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 
 }
 
+EPhysicalSurface AEnemy::GetFoostepsSurface()
+{
+	return FootstepSurfaceCache.GetSurface(this);
+}
+
+float AEnemy::CalculateAnimSignificance()
+{
+	const UWorld* World{ GetWorld() };
+	if (World == nullptr) return 0.f;
+
+	const FBoxSphereBounds& Bounds{ GetMesh()->Bounds };
+	float Significance{ 0.f };
+	for (FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		const APlayerController* PlayerController{ Iterator->Get() };
+		if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr) continue;
+
+		// Fraction of the view height covered by the bounds (half FOV is used for both axes, close enough for ranking)
+		const FVector ViewLocation{ PlayerController->PlayerCameraManager->GetCameraLocation() };
+		const float HalfFOVRadians{ FMath::DegreesToRadians(PlayerController->PlayerCameraManager->GetFOVAngle() * 0.5f) };
+		const float Distance{ FMath::Max(FVector::Dist(ViewLocation, Bounds.Origin), 1.f) };
+		const float ScreenSize{ Bounds.SphereRadius / (Distance * FMath::Tan(HalfFOVRadians)) };
+
+		Significance = FMath::Max(Significance, ScreenSize);
+	}
+
+	return Significance;
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "FootstepSurfaceCache.h"
 #include "Enemy.generated.h"
 
 UCLASS()
@@ -12,8 +13,8 @@ class BADASSSHOOTER_API AEnemy : public ACharacter
 	GENERATED_BODY()
 
 public:
-	// Sets default values for this character's properties
-	AEnemy();
+	// Sets default values for this character's properties (the mesh is a budgeted skeletal mesh)
+	AEnemy(const FObjectInitializer& ObjectInitializer);
 
 protected:
 	// Called when the game starts or when spawned
@@ -26,4 +27,18 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	/* Returns the surface the enemy is walking on (same footstep notifies as the shooter character) */
+	UFUNCTION(BlueprintCallable)
+	EPhysicalSurface GetFoostepsSurface();
+
+private:
+	/*
+	* Significance used by the animation budget allocator: screen size of the mesh bounds for the closest player view
+	* Large on screen enemies keep full rate animation, small or distant ones are ticked less often and interpolated
+	*/
+	float CalculateAnimSignificance();
+
+	/* Surface under the enemy, keyed on the character movement floor */
+	FFootstepSurfaceCache FootstepSurfaceCache;
+
 };
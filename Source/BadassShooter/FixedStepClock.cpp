@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FixedStepClock.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+
+static float GCombatStepRate{ 60.f };
+static FAutoConsoleVariableRef CVarCombatStepRate(
+	TEXT("Shooter.CombatStepRate"),
+	GCombatStepRate,
+	TEXT("Steps per second of the fixed step combat simulation (fire cadence, crosshair spread, weapon timers)"),
+	ECVF_Default);
+
+static int32 GCombatMaxSubSteps{ 4 };
+static FAutoConsoleVariableRef CVarCombatMaxSubSteps(
+	TEXT("Shooter.CombatMaxSubSteps"),
+	GCombatMaxSubSteps,
+	TEXT("Most combat steps simulated in one frame. Whole steps beyond that are dropped after a hitch"),
+	ECVF_Default);
+
+int32 FFixedStepClock::Advance(float DeltaTime)
+{
+	StepTime = 1.f / FMath::Clamp(GCombatStepRate, 10.f, 1000.f);
+	Accumulator += FMath::Max(DeltaTime, 0.f);
+
+	const int32 DueSteps{ FMath::FloorToInt(Accumulator / StepTime) };
+	Accumulator -= DueSteps * StepTime;
+	NumSteps = FMath::Min(DueSteps, FMath::Max(GCombatMaxSubSteps, 1));
+
+	return NumSteps;
+}
+
+const FFixedStepClock& UCombatClockSubsystem::GetClock()
+{
+	// Only game thread code simulates combat steps so a plain frame counter is enough
+	check(IsInGameThread());
+	if (Frame != GFrameCounter)
+	{
+		Frame = GFrameCounter;
+		// The HUD still reads the clock while the game is paused, no time passes for the simulation then
+		const UWorld* World = GetWorld();
+		Clock.Advance(World->IsPaused() ? 0.f : World->GetDeltaSeconds());
+	}
+	return Clock;
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FixedStepClock.generated.h"
+
+/*
+* Fixed timestep accumulator for the combat simulation (Shooter.CombatStepRate steps per second)
+* Frame time is added with Advance, which returns how many whole steps are due. Each step is simulated with GetStepTime so
+* the result does not depend on frame rate, and GetAlpha tells how far the frame is between the last step and the next one
+* so rendered values can be interpolated between the last two steps
+*/
+struct BADASSSHOOTER_API FFixedStepClock
+{
+	/*
+	* Adds the frame time and returns the number of steps to simulate
+	* At most Shooter.CombatMaxSubSteps are returned, the whole steps beyond that are dropped so catching up after a long hitch
+	* cannot snowball, the part of a step left over is kept
+	*/
+	int32 Advance(float DeltaTime);
+
+	/* Steps returned by the last Advance */
+	FORCEINLINE int32 GetNumSteps() const { return NumSteps; }
+
+	/* Length of one step in seconds */
+	FORCEINLINE float GetStepTime() const { return StepTime; }
+
+	/* Time since the last step as a fraction of a step (0 - 1) */
+	FORCEINLINE float GetAlpha() const { return FMath::Clamp(Accumulator / StepTime, 0.f, 1.f); }
+
+private:
+	/* Frame time that has not been simulated yet */
+	float Accumulator{ 0.f };
+
+	/* Step length used by the last Advance (the rate can be changed at runtime) */
+	float StepTime{ 1.f / 60.f };
+
+	int32 NumSteps{ 0 };
+};
+
+/*
+* The combat clock of one world, shared by everything that simulates in combat steps (the characters' fire cadence and crosshair spread,
+* the weapon motion) so they all run the same steps on a frame
+* The clock is advanced by the world's frame time the first time it is used on a frame
+*/
+UCLASS()
+class BADASSSHOOTER_API UCombatClockSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/* Brings the clock to the current frame and returns it */
+	const FFixedStepClock& GetClock();
+
+private:
+	FFixedStepClock Clock;
+
+	/* Frame the clock was last advanced on */
+	uint64 Frame{ 0 };
+};
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FootstepSurfaceCache.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Engine/World.h"
+#include "TraceBudget.h"
+#include "BadassShooter.h"
+
+namespace FootstepSurfaceCache
+{
+	/* Length of the trace below the character */
+	constexpr float TraceLength{ 400.f };
+
+	/* Distance above and below the floor impact point the floor trace covers */
+	constexpr float FloorTraceHalfLength{ 10.f };
+
+	/* Size of the cells surfaces are cached in on floors whose surface can change across the component (landscapes, multi material meshes) */
+	constexpr float SurfaceCellSize{ 200.f };
+
+	/* Cell of floors with a single surface, out of reach of any real cell */
+	const FIntVector WholeFloorCell{ MAX_int32 };
+
+	/* Stale entries are pruned when a world's shared cache grows past this */
+	constexpr int32 MaxSharedEntries{ 256 };
+}
+
+EPhysicalSurface FFootstepSurfaceCache::GetSurface(const ACharacter* Character)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GetFoostepsSurface);
+
+	if (Character == nullptr) return EPhysicalSurface::SurfaceType_Default;
+
+	const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+	const FFindFloorResult* Floor = Movement ? &Movement->CurrentFloor : nullptr;
+	UPrimitiveComponent* Component = Floor && Floor->bBlockingHit ? Floor->HitResult.GetComponent() : nullptr;
+
+	// No floor (in the air or landing this frame) so we have to trace
+	if (Component == nullptr)
+	{
+		if (!TryFootstepQuery(Character)) return Surface;
+
+		FloorComponent.Reset();
+		QueryWorldSurface(Character, Surface);
+		return Surface;
+	}
+
+	// Same floor (and cell of it) as last footstep
+	const FVector ImpactPoint{ Floor->HitResult.ImpactPoint };
+	const FIntVector Cell{ UFootstepSurfaceSubsystem::GetFloorCell(Component, ImpactPoint) };
+	if (FloorComponent.Get() == Component && FloorCell == Cell)
+	{
+		return Surface;
+	}
+
+	// Another character may have already queried this floor
+	UFootstepSurfaceSubsystem* SharedSurfaces = Character->GetWorld()->GetSubsystem<UFootstepSurfaceSubsystem>();
+	if (const EPhysicalSurface* SharedSurface = SharedSurfaces ? SharedSurfaces->FindSurface(Component, Cell) : nullptr)
+	{
+		FloorComponent = Component;
+		FloorCell = Cell;
+		Surface = *SharedSurface;
+		return Surface;
+	}
+
+	// Out of budget: keep the last surface and query this floor on a later footstep
+	if (!TryFootstepQuery(Character)) return Surface;
+
+	// A miss keeps the last surface and is not cached, the floor is queried again on the next footstep
+	if (!QueryFloorSurface(Component, ImpactPoint, Surface))
+	{
+		FloorComponent.Reset();
+		return Surface;
+	}
+
+	FloorComponent = Component;
+	FloorCell = Cell;
+	if (SharedSurfaces)
+	{
+		SharedSurfaces->AddSurface(Component, Cell, Surface);
+	}
+
+	return Surface;
+}
+
+bool FFootstepSurfaceCache::TryFootstepQuery(const ACharacter* Character)
+{
+	if (!FTraceBudget::TryLowPriorityQuery(Character->GetWorld()))
+	{
+		INC_DWORD_STAT(STAT_DroppedQueries);
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_FootstepQueries);
+	return true;
+}
+
+bool FFootstepSurfaceCache::QueryFloorSurface(UPrimitiveComponent* Component, const FVector& ImpactPoint, EPhysicalSurface& OutSurface)
+{
+	// Through the point the floor sweep touched, the capsule center can be off the floor (standing on a ledge)
+	FHitResult HitResult;
+	const FVector Start{ ImpactPoint + FVector(0.f, 0.f, FootstepSurfaceCache::FloorTraceHalfLength) };
+	const FVector End{ ImpactPoint - FVector(0.f, 0.f, FootstepSurfaceCache::FloorTraceHalfLength) };
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FootstepFloorTrace));
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	// Only the floor primitive is tested, not the whole scene
+	if (!Component->LineTraceComponent(HitResult, Start, End, QueryParams)) return false;
+
+	OutSurface = UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+	return true;
+}
+
+bool FFootstepSurfaceCache::QueryWorldSurface(const ACharacter* Character, EPhysicalSurface& OutSurface)
+{
+	FHitResult HitResult;
+	const FVector Start{ Character->GetActorLocation() };
+	const FVector End{ Start + FVector(0.f, 0.f, -FootstepSurfaceCache::TraceLength) };
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FootstepTrace), false, Character);
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	// Whatever blocks pawns can be walked on (static and movable floors), item area spheres only overlap pawns so they are skipped
+	if (!Character->GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Pawn, QueryParams)) return false;
+
+	OutSurface = UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+	return true;
+}
+
+FIntVector UFootstepSurfaceSubsystem::GetFloorCell(const UPrimitiveComponent* Floor, const FVector& ImpactPoint)
+{
+	if (Floor->GetNumMaterials() == 1) return FootstepSurfaceCache::WholeFloorCell;
+
+	const float CellSize{ FootstepSurfaceCache::SurfaceCellSize };
+	return FIntVector(FMath::FloorToInt(ImpactPoint.X / CellSize), FMath::FloorToInt(ImpactPoint.Y / CellSize), FMath::FloorToInt(ImpactPoint.Z / CellSize));
+}
+
+const EPhysicalSurface* UFootstepSurfaceSubsystem::FindSurface(const UPrimitiveComponent* Floor, const FIntVector& Cell) const
+{
+	return Surfaces.Find(MakeTuple(FObjectKey(Floor), Cell));
+}
+
+void UFootstepSurfaceSubsystem::AddSurface(const UPrimitiveComponent* Floor, const FIntVector& Cell, EPhysicalSurface Surface)
+{
+	if (Surfaces.Num() >= FootstepSurfaceCache::MaxSharedEntries)
+	{
+		for (auto It = Surfaces.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Get<0>().ResolveObjectPtr() == nullptr)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		// Every floor is still alive (large landscapes fill the cache with cells), start over
+		if (Surfaces.Num() >= FootstepSurfaceCache::MaxSharedEntries)
+		{
+			Surfaces.Reset();
+		}
+	}
+	Surfaces.Add(MakeTuple(FObjectKey(Floor), Cell), Surface);
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "FootstepSurfaceCache.generated.h"
+
+/*
+* Caches the physical surface a character is walking on for footstep sounds
+* The key is the floor primitive the character movement component already found (CurrentFloor) and, for floors whose surface varies
+* (landscapes, multi material meshes), the area around the floor impact point, so the surface is only
+* queried again when the character steps onto a different floor. Surfaces are also shared between the characters of a world
+* (player and enemies, see UFootstepSurfaceSubsystem) so a floor is only queried once no matter how many characters walk on it
+*/
+struct FFootstepSurfaceCache
+{
+	/* Returns the surface under the character (traces only when the floor changed since the last call) */
+	EPhysicalSurface GetSurface(const class ACharacter* Character);
+
+private:
+	/* Footstep traces are low priority, returns false when this frame's trace budget is used up (the last surface is reused) */
+	static bool TryFootstepQuery(const ACharacter* Character);
+
+	/* Trace against the floor component only to get its physical material, false (OutSurface untouched) if the trace misses */
+	static bool QueryFloorSurface(class UPrimitiveComponent* FloorComponent, const FVector& ImpactPoint, EPhysicalSurface& OutSurface);
+
+	/* Trace down into the world (used when the character has no floor e.g. when landing), false (OutSurface untouched) if nothing is below */
+	static bool QueryWorldSurface(const ACharacter* Character, EPhysicalSurface& OutSurface);
+
+	/* Floor and cell of it the cached surface belongs to (see UFootstepSurfaceSubsystem::GetFloorCell) */
+	TWeakObjectPtr<UPrimitiveComponent> FloorComponent;
+	FIntVector FloorCell{ ForceInitToZero };
+
+	EPhysicalSurface Surface{ EPhysicalSurface::SurfaceType_Default };
+};
+
+/* Footstep surfaces of the floors any character in the world has queried (see FFootstepSurfaceCache) */
+UCLASS()
+class BADASSSHOOTER_API UFootstepSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/*
+	* Part of the floor a surface is cached for
+	* Components with a single material have one surface, the floor sweep gives no face index so anything else
+	* (landscape layers, meshes with several materials) is cached per cell around the impact point
+	*/
+	static FIntVector GetFloorCell(const UPrimitiveComponent* Floor, const FVector& ImpactPoint);
+
+	/* Surface a character already found on the floor cell, nullptr if it was not queried yet */
+	const EPhysicalSurface* FindSurface(const UPrimitiveComponent* Floor, const FIntVector& Cell) const;
+
+	/* Shares a queried surface, stale entries are pruned once the cache is full */
+	void AddSurface(const UPrimitiveComponent* Floor, const FIntVector& Cell, EPhysicalSurface Surface);
+
+private:
+	TMap<TTuple<FObjectKey, FIntVector>, EPhysicalSurface> Surfaces;
+};
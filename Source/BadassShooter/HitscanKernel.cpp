@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanKernel.h"
+#include "Math/VectorRegister.h"
+#include "EngineUtils.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "CollisionQueryParams.h"
+#include "ShooterCharacter.h"
+#include "Enemy.h"
+#include "BadassShooter.h"
+
+namespace
+{
+	/* Number of floats in a VectorRegister */
+	constexpr int32 KernelWidth{ 4 };
+
+	/* Padding capsules sit this far away so they can never be hit */
+	constexpr float PaddingDistance{ 1.e9f };
+
+	/* Capsule between two bones of the mannequin skeleton */
+	struct FBoneCapsule
+	{
+		FName BoneA;
+		FName BoneB;
+		float Radius;
+	};
+
+	const TArray<FBoneCapsule>& GetBoneCapsules()
+	{
+		static const TArray<FBoneCapsule> BoneCapsules
+		{
+			{ FName(TEXT("head")), FName(TEXT("neck_01")), 12.f },
+			{ FName(TEXT("spine_03")), FName(TEXT("pelvis")), 18.f },
+			{ FName(TEXT("upperarm_l")), FName(TEXT("lowerarm_l")), 7.f },
+			{ FName(TEXT("lowerarm_l")), FName(TEXT("hand_l")), 6.f },
+			{ FName(TEXT("upperarm_r")), FName(TEXT("lowerarm_r")), 7.f },
+			{ FName(TEXT("lowerarm_r")), FName(TEXT("hand_r")), 6.f },
+			{ FName(TEXT("thigh_l")), FName(TEXT("calf_l")), 10.f },
+			{ FName(TEXT("calf_l")), FName(TEXT("foot_l")), 8.f },
+			{ FName(TEXT("thigh_r")), FName(TEXT("calf_r")), 10.f },
+			{ FName(TEXT("calf_r")), FName(TEXT("foot_r")), 8.f },
+		};
+		return BoneCapsules;
+	}
+}
+
+void FCapsuleHitboxes::Reset()
+{
+	AX.Reset(); AY.Reset(); AZ.Reset();
+	EX.Reset(); EY.Reset(); EZ.Reset();
+	ESizeSquared.Reset();
+	RadiusSquared.Reset();
+	Owners.Reset();
+	BoneNames.Reset();
+}
+
+void FCapsuleHitboxes::Add(const FVector& A, const FVector& B, float Radius, const AActor* Owner, FName BoneName)
+{
+	// Real capsules have to come before the padding
+	check(AX.Num() == Owners.Num());
+
+	const FVector E{ B - A };
+	AX.Add(A.X); AY.Add(A.Y); AZ.Add(A.Z);
+	EX.Add(E.X); EY.Add(E.Y); EZ.Add(E.Z);
+	ESizeSquared.Add(E.SizeSquared());
+	RadiusSquared.Add(FMath::Square(Radius));
+	Owners.Add(Owner);
+	BoneNames.Add(BoneName);
+}
+
+void FCapsuleHitboxes::Pad()
+{
+	while (AX.Num() % KernelWidth != 0)
+	{
+		AX.Add(PaddingDistance); AY.Add(PaddingDistance); AZ.Add(PaddingDistance);
+		EX.Add(0.f); EY.Add(0.f); EZ.Add(0.f);
+		ESizeSquared.Add(0.f);
+		RadiusSquared.Add(0.f);
+	}
+}
+
+void FHitscanKernel::GatherPawnHitboxes(const UWorld* World, const AActor* IgnoredPawn, FCapsuleHitboxes& OutHitboxes)
+{
+	OutHitboxes.Reset();
+	if (World == nullptr) return;
+
+	for (TActorIterator<ACharacter> It(World); It; ++It)
+	{
+		const ACharacter* Pawn = *It;
+		if (Pawn == IgnoredPawn || !(Pawn->IsA<AShooterCharacter>() || Pawn->IsA<AEnemy>())) continue;
+
+		// Bone transforms are whatever the mesh last evaluated (on a dedicated server that can be the reference pose, which is still close enough to find candidates)
+		const int32 NumBefore{ OutHitboxes.Num() };
+		const USkeletalMeshComponent* Mesh = Pawn->GetMesh();
+		if (Mesh && Mesh->SkeletalMesh)
+		{
+			const float Scale{ Mesh->GetComponentScale().GetAbsMax() };
+			for (const FBoneCapsule& BoneCapsule : GetBoneCapsules())
+			{
+				const int32 BoneIndexA{ Mesh->GetBoneIndex(BoneCapsule.BoneA) };
+				const int32 BoneIndexB{ Mesh->GetBoneIndex(BoneCapsule.BoneB) };
+				if (BoneIndexA == INDEX_NONE || BoneIndexB == INDEX_NONE) continue;
+
+				OutHitboxes.Add(
+					Mesh->GetBoneTransform(BoneIndexA).GetLocation(),
+					Mesh->GetBoneTransform(BoneIndexB).GetLocation(),
+					BoneCapsule.Radius * Scale,
+					Pawn,
+					BoneCapsule.BoneA);
+			}
+		}
+
+		if (OutHitboxes.Num() == NumBefore)
+		{
+			// Skeleton without the mannequin bones, the collision capsule is the only hitbox
+			const UCapsuleComponent* Capsule = Pawn->GetCapsuleComponent();
+			const FVector Center{ Capsule->GetComponentLocation() };
+			const FVector HalfSegment{ Capsule->GetUpVector() * Capsule->GetScaledCapsuleHalfHeight_WithoutHemisphere() };
+			OutHitboxes.Add(Center - HalfSegment, Center + HalfSegment, Capsule->GetScaledCapsuleRadius(), Pawn, NAME_None);
+		}
+	}
+
+	OutHitboxes.Pad();
+}
+
+void FHitscanKernel::IntersectRays(TArrayView<const FHitscanRay> Rays, const FCapsuleHitboxes& Hitboxes, TArray<FHitscanCandidate>& OutCandidates)
+{
+	OutCandidates.Reset();
+	OutCandidates.SetNum(Rays.Num());
+
+	const int32 NumPadded{ Hitboxes.NumPadded() };
+	checkSlow(NumPadded % KernelWidth == 0);
+
+	const VectorRegister Zero{ VectorZero() };
+	const VectorRegister One{ VectorOne() };
+	const VectorRegister Epsilon{ VectorSetFloat1(KINDA_SMALL_NUMBER) };
+
+	for (int32 RayIndex = 0; RayIndex < Rays.Num(); RayIndex++)
+	{
+		const FHitscanRay& Ray = Rays[RayIndex];
+		const VectorRegister OX{ VectorSetFloat1(Ray.Origin.X) };
+		const VectorRegister OY{ VectorSetFloat1(Ray.Origin.Y) };
+		const VectorRegister OZ{ VectorSetFloat1(Ray.Origin.Z) };
+		const VectorRegister DX{ VectorSetFloat1(Ray.Direction.X) };
+		const VectorRegister DY{ VectorSetFloat1(Ray.Direction.Y) };
+		const VectorRegister DZ{ VectorSetFloat1(Ray.Direction.Z) };
+		const VectorRegister Length{ VectorSetFloat1(Ray.Length) };
+
+		FHitscanCandidate& Candidate = OutCandidates[RayIndex];
+		float ClosestDistance{ Ray.Length };
+
+		for (int32 Base = 0; Base < NumPadded; Base += KernelWidth)
+		{
+			const VectorRegister EX{ VectorLoad(&Hitboxes.EX[Base]) };
+			const VectorRegister EY{ VectorLoad(&Hitboxes.EY[Base]) };
+			const VectorRegister EZ{ VectorLoad(&Hitboxes.EZ[Base]) };
+			const VectorRegister C{ VectorLoad(&Hitboxes.ESizeSquared[Base]) };
+
+			// W = O - A
+			const VectorRegister WX{ VectorSubtract(OX, VectorLoad(&Hitboxes.AX[Base])) };
+			const VectorRegister WY{ VectorSubtract(OY, VectorLoad(&Hitboxes.AY[Base])) };
+			const VectorRegister WZ{ VectorSubtract(OZ, VectorLoad(&Hitboxes.AZ[Base])) };
+
+			// Closest points between the ray segment O + s * D (s in [0, Length]) and the capsule segment A + t * E (t in [0, 1])
+			const VectorRegister B{ VectorMultiplyAdd(DX, EX, VectorMultiplyAdd(DY, EY, VectorMultiply(DZ, EZ))) };
+			const VectorRegister D{ VectorMultiplyAdd(DX, WX, VectorMultiplyAdd(DY, WY, VectorMultiply(DZ, WZ))) };
+			const VectorRegister E{ VectorMultiplyAdd(EX, WX, VectorMultiplyAdd(EY, WY, VectorMultiply(EZ, WZ))) };
+
+			const VectorRegister Denominator{ VectorSubtract(C, VectorMultiply(B, B)) };
+			const VectorRegister Numerator{ VectorSubtract(VectorMultiply(B, E), VectorMultiply(C, D)) };
+			VectorRegister S{ VectorSelect(VectorCompareGT(Denominator, Epsilon), VectorDivide(Numerator, VectorMax(Denominator, Epsilon)), Zero) };
+			S = VectorMin(VectorMax(S, Zero), Length);
+
+			VectorRegister T{ VectorDivide(VectorMultiplyAdd(B, S, E), VectorMax(C, Epsilon)) };
+			T = VectorMin(VectorMax(T, Zero), One);
+			S = VectorMin(VectorMax(VectorSubtract(VectorMultiply(B, T), D), Zero), Length);
+
+			// P - Q = W + s * D - t * E
+			const VectorRegister PX{ VectorSubtract(VectorMultiplyAdd(DX, S, WX), VectorMultiply(EX, T)) };
+			const VectorRegister PY{ VectorSubtract(VectorMultiplyAdd(DY, S, WY), VectorMultiply(EY, T)) };
+			const VectorRegister PZ{ VectorSubtract(VectorMultiplyAdd(DZ, S, WZ), VectorMultiply(EZ, T)) };
+			const VectorRegister DistanceSquared{ VectorMultiplyAdd(PX, PX, VectorMultiplyAdd(PY, PY, VectorMultiply(PZ, PZ))) };
+
+			const VectorRegister RadiusSquared{ VectorLoad(&Hitboxes.RadiusSquared[Base]) };
+			const int32 HitMask{ VectorMaskBits(VectorCompareGE(RadiusSquared, DistanceSquared)) };
+			if (HitMask == 0) continue;
+
+			// Rare path: only lanes that hit are resolved to a distance
+			alignas(16) float SValues[KernelWidth];
+			alignas(16) float DistanceSquaredValues[KernelWidth];
+			alignas(16) float RadiusSquaredValues[KernelWidth];
+			VectorStoreAligned(S, SValues);
+			VectorStoreAligned(DistanceSquared, DistanceSquaredValues);
+			VectorStoreAligned(RadiusSquared, RadiusSquaredValues);
+
+			for (int32 Lane = 0; Lane < KernelWidth; Lane++)
+			{
+				if ((HitMask & (1 << Lane)) == 0) continue;
+
+				// Step back from the closest point to the capsule surface (exact for the spherical caps, close enough for the sides)
+				const float Distance{ FMath::Max(SValues[Lane] - FMath::Sqrt(FMath::Max(RadiusSquaredValues[Lane] - DistanceSquaredValues[Lane], 0.f)), 0.f) };
+				if (Distance < ClosestDistance || Candidate.CapsuleIndex == INDEX_NONE)
+				{
+					ClosestDistance = Distance;
+					Candidate.CapsuleIndex = Base + Lane;
+					Candidate.Distance = Distance;
+				}
+			}
+		}
+	}
+}
+
+void FHitscanKernel::IntersectRaysScalar(TArrayView<const FHitscanRay> Rays, const FCapsuleHitboxes& Hitboxes, TArray<FHitscanCandidate>& OutCandidates)
+{
+	OutCandidates.Reset();
+	OutCandidates.SetNum(Rays.Num());
+
+	for (int32 RayIndex = 0; RayIndex < Rays.Num(); RayIndex++)
+	{
+		const FHitscanRay& Ray = Rays[RayIndex];
+		FHitscanCandidate& Candidate = OutCandidates[RayIndex];
+		float ClosestDistance{ Ray.Length };
+
+		for (int32 Index = 0; Index < Hitboxes.Num(); Index++)
+		{
+			const FVector A{ Hitboxes.AX[Index], Hitboxes.AY[Index], Hitboxes.AZ[Index] };
+			const FVector E{ Hitboxes.EX[Index], Hitboxes.EY[Index], Hitboxes.EZ[Index] };
+			const FVector W{ Ray.Origin - A };
+			const float C{ Hitboxes.ESizeSquared[Index] };
+			const float B{ FVector::DotProduct(Ray.Direction, E) };
+			const float D{ FVector::DotProduct(Ray.Direction, W) };
+			const float EW{ FVector::DotProduct(E, W) };
+
+			const float Denominator{ C - B * B };
+			float S{ Denominator > KINDA_SMALL_NUMBER ? (B * EW - C * D) / Denominator : 0.f };
+			S = FMath::Clamp(S, 0.f, Ray.Length);
+			const float T{ FMath::Clamp((B * S + EW) / FMath::Max(C, KINDA_SMALL_NUMBER), 0.f, 1.f) };
+			S = FMath::Clamp(B * T - D, 0.f, Ray.Length);
+
+			const float DistanceSquared{ (W + Ray.Direction * S - E * T).SizeSquared() };
+			const float RadiusSquared{ Hitboxes.RadiusSquared[Index] };
+			if (DistanceSquared > RadiusSquared) continue;
+
+			const float Distance{ FMath::Max(S - FMath::Sqrt(RadiusSquared - DistanceSquared), 0.f) };
+			if (Distance < ClosestDistance || Candidate.CapsuleIndex == INDEX_NONE)
+			{
+				ClosestDistance = Distance;
+				Candidate.CapsuleIndex = Index;
+				Candidate.Distance = Distance;
+			}
+		}
+	}
+}
+
+/*---- BENCHMARK ----*/
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+	/* Shooter.HitscanKernelBenchmark [NumRays]: times the kernel against one LineTraceSingleByChannel per ray */
+	void RunHitscanKernelBenchmark(const TArray<FString>& Args, UWorld* World)
+	{
+		const int32 NumRays{ Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 4096 };
+
+		FCapsuleHitboxes Hitboxes;
+		FHitscanKernel::GatherPawnHitboxes(World, nullptr, Hitboxes);
+		if (Hitboxes.Num() == 0)
+		{
+			UE_LOG(LogBadassShooter, Warning, TEXT("HitscanKernelBenchmark: no pawns in the world"));
+			return;
+		}
+
+		// Rays from random points around the pawns aimed roughly at one of their hitboxes
+		FRandomStream Stream(NumRays);
+		TArray<FHitscanRay> Rays;
+		Rays.Reserve(NumRays);
+		for (int32 i = 0; i < NumRays; i++)
+		{
+			const int32 Target{ Stream.RandRange(0, Hitboxes.Num() - 1) };
+			const FVector TargetLocation{ Hitboxes.AX[Target], Hitboxes.AY[Target], Hitboxes.AZ[Target] };
+			const FVector Origin{ TargetLocation + Stream.GetUnitVector() * Stream.FRandRange(500.f, 3000.f) };
+			const FVector AimPoint{ TargetLocation + Stream.GetUnitVector() * Stream.FRandRange(0.f, 60.f) };
+			Rays.Add({ Origin, (AimPoint - Origin).GetSafeNormal(), 5000.f });
+		}
+
+		TArray<FHitscanCandidate> Candidates;
+		double StartTime{ FPlatformTime::Seconds() };
+		FHitscanKernel::IntersectRays(Rays, Hitboxes, Candidates);
+		const double KernelTime{ FPlatformTime::Seconds() - StartTime };
+
+		TArray<FHitscanCandidate> ScalarCandidates;
+		StartTime = FPlatformTime::Seconds();
+		FHitscanKernel::IntersectRaysScalar(Rays, Hitboxes, ScalarCandidates);
+		const double ScalarTime{ FPlatformTime::Seconds() - StartTime };
+
+		int32 NumTraceHits{ 0 };
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitscanKernelBenchmark), false);
+		StartTime = FPlatformTime::Seconds();
+		for (const FHitscanRay& Ray : Rays)
+		{
+			FHitResult HitResult;
+			NumTraceHits += World->LineTraceSingleByChannel(HitResult, Ray.Origin, Ray.Origin + Ray.Direction * Ray.Length, ECC_WeaponFire, QueryParams) ? 1 : 0;
+		}
+		const double TraceTime{ FPlatformTime::Seconds() - StartTime };
+
+		int32 NumKernelHits{ 0 };
+		int32 NumMismatches{ 0 };
+		for (int32 i = 0; i < NumRays; i++)
+		{
+			NumKernelHits += Candidates[i].CapsuleIndex != INDEX_NONE ? 1 : 0;
+			NumMismatches += Candidates[i].CapsuleIndex != ScalarCandidates[i].CapsuleIndex ? 1 : 0;
+		}
+
+		UE_LOG(LogBadassShooter, Display, TEXT("HitscanKernelBenchmark: %d rays against %d capsules"), NumRays, Hitboxes.Num());
+		UE_LOG(LogBadassShooter, Display, TEXT("  Vector kernel: %.3f ms (%d candidate hits)"), KernelTime * 1000.0, NumKernelHits);
+		UE_LOG(LogBadassShooter, Display, TEXT("  Scalar kernel: %.3f ms (%d mismatches with the vector kernel)"), ScalarTime * 1000.0, NumMismatches);
+		UE_LOG(LogBadassShooter, Display, TEXT("  LineTraceSingleByChannel: %.3f ms (%d blocking hits)"), TraceTime * 1000.0, NumTraceHits);
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs HitscanKernelBenchmarkCommand(
+		TEXT("Shooter.HitscanKernelBenchmark"),
+		TEXT("Times the hitscan capsule kernel against LineTraceSingleByChannel. Usage: Shooter.HitscanKernelBenchmark [NumRays]"),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunHitscanKernelBenchmark));
+}
+#endif
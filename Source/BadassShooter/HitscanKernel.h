@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* A single shot ray (Direction is a unit vector) */
+struct FHitscanRay
+{
+	FVector Origin;
+	FVector Direction;
+	float Length;
+};
+
+/*
+* Simplified capsule hitboxes (head, torso, limbs) of every pawn, stored as structure of arrays so the kernel can load
+* four capsules into one vector register. Each capsule is the segment A -> A + E with a radius
+* The arrays are padded to a multiple of the vector width with capsules that can never be hit
+*/
+struct FCapsuleHitboxes
+{
+	TArray<float> AX, AY, AZ;
+	TArray<float> EX, EY, EZ;
+
+	/* E dot E (squared segment length) */
+	TArray<float> ESizeSquared;
+	TArray<float> RadiusSquared;
+
+	/* Pawn and bone each capsule belongs to (only valid for the frame the hitboxes were gathered in) */
+	TArray<const AActor*> Owners;
+	TArray<FName> BoneNames;
+
+	void Reset();
+	void Add(const FVector& A, const FVector& B, float Radius, const AActor* Owner, FName BoneName);
+
+	/* Pads the arrays to a multiple of the vector width (called once all capsules are added) */
+	void Pad();
+
+	/* Number of real capsules (without padding) */
+	FORCEINLINE int32 Num() const { return Owners.Num(); }
+	FORCEINLINE int32 NumPadded() const { return AX.Num(); }
+};
+
+/* Closest capsule a ray hits (CapsuleIndex is INDEX_NONE when the ray misses every capsule) */
+struct FHitscanCandidate
+{
+	int32 CapsuleIndex{ INDEX_NONE };
+
+	/* Distance along the ray to the capsule surface */
+	float Distance{ 0.f };
+};
+
+/*
+* Tests batches of shot rays against pawn hitboxes without going through the physics scene
+* Only pawn hitboxes are tested, the caller resolves the rest of the scene and keeps whichever hit is closer
+* Nothing in here depends on rendering so it runs the same on a dedicated server
+*/
+struct FHitscanKernel
+{
+	/* Collects the hitboxes of every AShooterCharacter and AEnemy in the world except IgnoredPawn */
+	static void GatherPawnHitboxes(const UWorld* World, const AActor* IgnoredPawn, FCapsuleHitboxes& OutHitboxes);
+
+	/* Finds the closest capsule hit for every ray, four capsules per instruction */
+	static void IntersectRays(TArrayView<const FHitscanRay> Rays, const FCapsuleHitboxes& Hitboxes, TArray<FHitscanCandidate>& OutCandidates);
+
+	/* Scalar version of IntersectRays (reference for the benchmark and for checking the vector path) */
+	static void IntersectRaysScalar(TArrayView<const FHitscanRay> Rays, const FCapsuleHitboxes& Hitboxes, TArray<FHitscanCandidate>& OutCandidates);
+};
@@ -9,6 +9,15 @@
 #include "Kismet/GameplayStatics.h"
 #include "Sound/SoundCue.h"
 #include "Curves/CurveVector.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "ItemPulseSubsystem.h"
+#include "ItemSignificanceSubsystem.h"
+#include "ItemInterpSubsystem.h"
+#include "ShooterDataSubsystem.h"
+#include "PickupStoreSubsystem.h"
+
+const FName AItem::PickupProfileName(TEXT("Pickup"));
+const FName AItem::PickupAreaProfileName(TEXT("PickupArea"));
 
 // Sets default values
 AItem::AItem():
@@ -28,33 +37,40 @@ AItem::AItem():
 	MaterialIndex(0),
 	// Pulse Material Parameters
 	PulseDuration(3.f),
+	bGlowEnabled(true),
+	ItemInterpStartTime(0.f),
 	GlowBlendAlpha(150.f),
 	FresnelExponent(4.f),
 	FrenselReflectionFraction(3.f),
 	// Custom Depth
 	bCanChangeCustomDepth(true),
+	// Significance
+	Significance(EItemSignificance::High),
+	bInRelevanceRange(false),	// Set by the significance subsystem on its first update
 	// Inventory
 	SlotIndex(0),
 	bInventoryIsFull(false),
 	// Data Table
 	ItemRarityText(FString("Cool"))
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Pulsing and interpolation are driven by UItemPulseSubsystem and UItemInterpSubsystem, items never tick themselves
+	PrimaryActorTick.bCanEverTick = false;
 
 	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ItemMesh"));
 	SetRootComponent(ItemMesh);
 
 	CollisionBox = CreateDefaultSubobject<UBoxComponent>(TEXT("CollisionBox"));
 	CollisionBox->SetupAttachment(ItemMesh);
-	CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-	CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
+	CollisionBox->SetCollisionProfileName(PickupProfileName);
 
 	PickupWidget = CreateDefaultSubobject<UWidgetComponent>(TEXT("PickupWidget"));
 	PickupWidget->SetupAttachment(RootComponent);
+	// HUD work goes last in the frame, after the item and the character have moved
+	PickupWidget->PrimaryComponentTick.TickGroup = TG_LastDemotable;
 
 	AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
 	AreaSphere->SetupAttachment(GetRootComponent());
+	AreaSphere->SetCollisionProfileName(PickupAreaProfileName);
 
 }
 
@@ -82,22 +98,40 @@ void AItem::BeginPlay()
 	// Turn of custom depth to start 
 	InitializeCustomDepth();
 
-	// Start the pulse effect
-	StartPulseTimer();
-}
+	// Widget tick and overlaps are scaled back by the significance subsystem when nobody is close
+	if (UItemSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UItemSignificanceSubsystem>())
+	{
+		SignificanceSubsystem->RegisterItem(this);
+	}
 
+	// Stowed as a record while no player is near
+	if (UPickupStoreSubsystem* PickupStore = GetWorld()->GetSubsystem<UPickupStoreSubsystem>())
+	{
+		PickupStore->RegisterItem(this);
+	}
+	ApplySignificance();
+}
 
-// Called every frame
-void AItem::Tick(float DeltaTime)
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-
-	// Check if bIsInterping and start interpolation
-	InterpolateItemLocation(DeltaTime);
-
-	// Get the pulse effect going
-	UpdatePulseParameters();
+	Super::EndPlay(EndPlayReason);
 
+	if (UItemPulseSubsystem* PulseSubsystem = GetWorld()->GetSubsystem<UItemPulseSubsystem>())
+	{
+		PulseSubsystem->UnregisterItem(this);
+	}
+	if (UItemSignificanceSubsystem* SignificanceSubsystem = GetWorld()->GetSubsystem<UItemSignificanceSubsystem>())
+	{
+		SignificanceSubsystem->UnregisterItem(this);
+	}
+	if (UItemInterpSubsystem* InterpSubsystem = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+	{
+		InterpSubsystem->RemoveItem(this);
+	}
+	if (UPickupStoreSubsystem* PickupStore = GetWorld()->GetSubsystem<UPickupStoreSubsystem>())
+	{
+		PickupStore->UnregisterItem(this);
+	}
 }
 
 void AItem::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
@@ -133,10 +167,8 @@ void AItem::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor*
 
 void AItem::SetItemRarityAndStars()
 {
-	for (int32 i = 0; i < 5; i++)
-	{
-		ActiveStars.Add(false);
-	}
+	// Reset so an item that changes rarity (pooled items) does not keep its old stars
+	ActiveStars.Init(false, 5);
 
 	// Set from right to left so the stars are aligned to right of widget
 	switch (ItemRarity)
@@ -186,13 +218,10 @@ void AItem::SetItemProperties(EItemState State)
 		ItemMesh->SetVisibility(true);
 		ItemMesh->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
 		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set AreaSphere Properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Overlap);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
-		// Set CollisionBox properties
-		CollisionBox->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-		CollisionBox->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
-		CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		// Set AreaSphere Properties (overlaps pawns only)
+		AreaSphere->SetCollisionProfileName(PickupAreaProfileName);
+		// Set CollisionBox properties (only found by Pickup object queries, ignored by weapon fire)
+		CollisionBox->SetCollisionProfileName(PickupProfileName);
 		break;
 	case EItemState::EIS_Equipped:
 		// Set Pickup Widget
@@ -265,6 +294,8 @@ void AItem::SetItemState(EItemState State)
 {
 	ItemState = State;
 	SetItemProperties(State);
+	UpdateGlowMaterial();
+	ApplySignificance();
 }
 
 void AItem::StartItemCurveInterpTimer(AShooterCharacter* Character, bool bForcePlaySound)
@@ -281,14 +312,20 @@ void AItem::StartItemCurveInterpTimer(AShooterCharacter* Character, bool bForceP
 	// Set Item Start location
 	ItemInterpStartLocation = GetActorLocation();
 
-	// Set IsInterping and ItemState
+	// Set IsInterping and ItemState (the interp pulse starts now)
 	bIsInterping = true;
+	ItemInterpStartTime = GetWorld()->GetTimeSeconds();
 	SetItemState(EItemState::EIS_EquipInterping);
-	GetWorldTimerManager().ClearTimer(PulseTimer);
 
 	// Start the Timer
 	GetWorldTimerManager().SetTimer(ItemInterpTimer, this, &AItem::EndItemInterpTimer, ItemZCurveInterpTime);
 
+	// The interp subsystem moves the item until the timer ends
+	if (UItemInterpSubsystem* InterpSubsystem = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+	{
+		InterpSubsystem->AddItem(this);
+	}
+
 	bCanChangeCustomDepth = false;
 }
 
@@ -342,6 +379,10 @@ void AItem::EndItemInterpTimer()
 	ShooterCharacterRef->IncrementInterpLocationsItemCount(InterpLocationIndex, -1);
 
 	bIsInterping = false;
+	if (UItemInterpSubsystem* InterpSubsystem = GetWorld()->GetSubsystem<UItemInterpSubsystem>())
+	{
+		InterpSubsystem->RemoveItem(this);
+	}
 	if (ShooterCharacterRef)
 	{
 		ShooterCharacterRef->GetPickupItem(this);
@@ -360,50 +401,29 @@ void AItem::EndItemInterpTimer()
 	DisableCustomDepth();
 }
 
-void AItem::InterpolateItemLocation(float DeltaTime)
+bool AItem::GetInterpJob(float WorldTime, FItemInterpJob& OutJob)
 {
-	if (!bIsInterping) return;
+	if (!bIsInterping || ShooterCharacterRef == nullptr || ItemZCurve == nullptr) return false;
 
-	if (ShooterCharacterRef && ItemZCurve)
-	{
-		// Get amount of time elapsed after the item interp timer has started
-		const float ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
-
-		// Get the value of the item z curve at the elapsed time
-		const float CurveValue = ItemZCurve->GetFloatValue(ElapsedTime);
-
-		// All Z calculations are based on the Z of the start location
-		FVector ItemLocation = ItemInterpStartLocation;
-
-		// This is where the end locaiton of the camera is (a little in front and above the camera)
-		//const FVector CameraLocation = ShooterCharacterRef->GetCameraInterpEndLocation();
-		const FVector CameraLocation = GetInterpLocation();
-
-		// Calculate the Delta Between the Item Location and the Camera Location so the item will rise
-		const FVector ItemToCameraVector{ 0.f, 0.f, (CameraLocation - ItemLocation).Z };
-		const float DeltaZ = ItemToCameraVector.Size();
-
-		// Linear Interpolation of the X and Y value
-		const FVector ItemCurrentLocation = GetActorLocation();
-		const float ItemXValue = FMath::FInterpTo(ItemCurrentLocation.X, CameraLocation.X, DeltaTime, 30.f);
-		const float ItemYValue = FMath::FInterpTo(ItemCurrentLocation.Y, CameraLocation.Y, DeltaTime, 30.f);
-
-		ItemLocation.X = ItemXValue;
-		ItemLocation.Y = ItemYValue;
+	OutJob.Item = this;
+	OutJob.StartLocation = ItemInterpStartLocation;
+	OutJob.CurrentLocation = GetActorLocation();
 
-		// Add the delta to the item location and set the actor location
-		ItemLocation.Z += CurveValue * DeltaZ;
-		SetActorLocation(ItemLocation, true, nullptr, ETeleportType::TeleportPhysics);
+	// This is where the end locaiton of the camera is (a little in front and above the camera)
+	OutJob.TargetLocation = GetInterpLocation();
 
-		if (ItemScaleCurve)
-		{
-			// Shrink Item as the interpolation happens
-			const float CurveScaleValue = ItemScaleCurve->GetFloatValue(ElapsedTime);
-			SetActorScale3D(FVector(CurveScaleValue, CurveScaleValue, CurveScaleValue));
-		}
-
-	}
+	// Amount of time elapsed after the item interp timer has started
+	OutJob.ElapsedTime = WorldTime - ItemInterpStartTime;
+	OutJob.ZCurve = ItemZCurve;
+	OutJob.ScaleCurve = ItemScaleCurve;
+	return true;
+}
 
+void AItem::ApplyInterpJob(const FItemInterpJob& Job)
+{
+	// Location and scale in one transform update and no sweep (interping items have collision disabled)
+	const FVector Scale{ Job.ScaleCurve ? FVector(Job.Scale) : GetActorScale3D() };
+	SetActorTransform(FTransform(GetActorQuat(), Job.Location, Scale), false, nullptr, ETeleportType::TeleportPhysics);
 }
 
 FVector AItem::GetInterpLocation()
@@ -428,127 +448,132 @@ void AItem::OnConstruction(const FTransform& Transform)
 {
 	
 
-	// Load data from Item Rarity Data Table
-
-	// Path to ItemRarityDataTable
-	const FString RarityTablePath(TEXT("DataTable'/Game/_Game/DataTables/ItemRarityDataTable.ItemRarityDataTable'"));
-
-	// StaticLoadObject is like CreateDefaultSubobject which creates an object of a UCLASS
-	UDataTable* RarityTableObject = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, *RarityTablePath));
-
-	if (RarityTableObject)
+	// Load data from Item Rarity Data Table (loaded once and indexed by rarity in the data subsystem)
+	const UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+	const FItemRarityTable* RarityRow = DataSubsystem ? DataSubsystem->GetRarityRow(ItemRarity) : nullptr;
+	if (RarityRow)
 	{
-		FItemRarityTable* RarityRow = nullptr;
-		switch (ItemRarity)
+		GlowColor = RarityRow->GlowColor;
+		TextColor = RarityRow->TextColor;
+		NumberofStars = RarityRow->NumberofStars;
+		BackgroundImage = RarityRow->BackgroundIcon; // Will fix naming convention later
+		ItemRarityText = RarityRow->ItemRarityText;
+		if (GetItemMesh())
 		{
-		case EItemRarity::EIR_Lame:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName(TEXT("Lame")), TEXT(""));
-			break;
-		case EItemRarity::EIR_Okay:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName(TEXT("Okay")), TEXT(""));
-			break;
-		case EItemRarity::EIR_Cool:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName(TEXT("Cool")), TEXT(""));
-			break;
-		case EItemRarity::EIR_Crazy:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName(TEXT("Crazy")), TEXT(""));
-			break;
-		case EItemRarity::EIR_Badass:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName(TEXT("Badass")), TEXT(""));
-			break;
-		}
-
-		if (RarityRow)
-		{
-			GlowColor = RarityRow->GlowColor;
-			TextColor = RarityRow->TextColor;
-			NumberofStars = RarityRow->NumberofStars;
-			BackgroundImage = RarityRow->BackgroundIcon; // Will fix naming convention later
-			ItemRarityText = RarityRow->ItemRarityText;
-			if (GetItemMesh())
-			{
-				GetItemMesh()->SetCustomDepthStencilValue(RarityRow->CustomDepthStencilValue);
-			}
+			GetItemMesh()->SetCustomDepthStencilValue(RarityRow->CustomDepthStencilValue);
 		}
 	}
+	SetItemRarityAndStars();
 
-	if (MaterialInstance)
-	{
-		// Construct dynamic material instance based on material instance
-		DynamicMaterialInstance = UMaterialInstanceDynamic::Create(MaterialInstance, this);
-		DynamicMaterialInstance->SetVectorParameterValue(FName(TEXT("FresnelColor")), GlowColor);
+	ApplyGlowMaterial();
+}
 
-		// Set the dynamic material instance to the mesh 
-		ItemMesh->SetMaterial(MaterialIndex, DynamicMaterialInstance);
+void AItem::ApplyGlowMaterial()
+{
+	// Turn on the glow material
+	bGlowEnabled = true;
+	UpdateGlowMaterial();
+}
 
-		// Turn on the glow material
-		EnableGlowMaterial();
+void AItem::UpdateGlowMaterial()
+{
+	if (MaterialInstance == nullptr || ItemMesh == nullptr) return;
+
+	UWorld* World = GetWorld();
+	UItemPulseSubsystem* PulseSubsystem = World && World->IsGameWorld() ? World->GetSubsystem<UItemPulseSubsystem>() : nullptr;
+	if (PulseSubsystem && ItemState != EItemState::EIS_EquipInterping)
+	{
+		// Items on the ground pulse in phase, so one material per material instance and rarity is pulsed once per frame for all of them
+		DynamicMaterialInstance = PulseSubsystem->GetSharedGlowMaterial(this, bGlowEnabled);
 	}
-	
+	else
+	{
+		// The interp pulse starts when the item is picked up, so the item needs its own material for it
+		// Editor worlds get their own as well, outered to the item so placed items save their own instance with the map
+		if (DynamicMaterialInstance == nullptr || DynamicMaterialInstance->GetOuter() != this || DynamicMaterialInstance->Parent != MaterialInstance)
+		{
+			DynamicMaterialInstance = UMaterialInstanceDynamic::Create(MaterialInstance, this);
+		}
+		DynamicMaterialInstance->SetVectorParameterValue(FName(TEXT("FresnelColor")), GlowColor);
+		DynamicMaterialInstance->SetScalarParameterValue(TEXT("GlowBlendAlpha"), bGlowEnabled ? 0.f : 1.f);
+	}
+
+	// Set the dynamic material instance to the mesh
+	ItemMesh->SetMaterial(MaterialIndex, DynamicMaterialInstance);
 }
 
 void AItem::EnableGlowMaterial()
 {
-	if (DynamicMaterialInstance)
+	if (!bGlowEnabled)
 	{
-		DynamicMaterialInstance->SetScalarParameterValue(TEXT("GlowBlendAlpha"), 0);
+		bGlowEnabled = true;
+		UpdateGlowMaterial();
 	}
 }
 
 void AItem::DisableGlowMaterial()
 {
-	if (DynamicMaterialInstance)
+	if (bGlowEnabled)
 	{
-		DynamicMaterialInstance->SetScalarParameterValue(TEXT("GlowBlendAlpha"), 1);
+		bGlowEnabled = false;
+		UpdateGlowMaterial();
 	}
 }
 
-void AItem::StartPulseTimer()
+bool AItem::GetPulseSample(float WorldTime, UCurveVector*& OutCurve, float& OutCurveTime) const
 {
-	if (ItemState == EItemState::EIS_Pickup)
-	{
-		GetWorldTimerManager().SetTimer(PulseTimer, this, &AItem::ResetPulseTimer, PulseDuration);
-	}
+	// Items on the ground are pulsed through their shared material
+	if (ItemState != EItemState::EIS_EquipInterping) return false;
+
+	OutCurve = InterpPulseCurve;
+	OutCurveTime = WorldTime - ItemInterpStartTime;
+
+	// Items without their own material (or curve) have nothing to pulse
+	return OutCurve != nullptr && DynamicMaterialInstance != nullptr && DynamicMaterialInstance->GetOuter() == this;
 }
 
-void AItem::ResetPulseTimer()
+void AItem::ApplyPulse(const FVector& CurveValue)
 {
-	StartPulseTimer();
+	UItemPulseSubsystem::SetPulseParameters(DynamicMaterialInstance, CurveValue, GetPulseScale());
 }
 
-void AItem::UpdatePulseParameters()
+void AItem::UpdatePulseRegistration()
 {
-	float ElapsedTime{};
-	FVector CurveValue{};
+	UWorld* World = GetWorld();
+	UItemPulseSubsystem* PulseSubsystem = World ? World->GetSubsystem<UItemPulseSubsystem>() : nullptr;
+	if (PulseSubsystem == nullptr) return;
 
-	switch (ItemState)
+	// Only the interp pulse is per item
+	const bool bPulses{ ItemState == EItemState::EIS_EquipInterping && DynamicMaterialInstance };
+	if (bPulses)
 	{
-	case EItemState::EIS_Pickup:
-		if (PulseCurve)
-		{
-			ElapsedTime = GetWorldTimerManager().GetTimerElapsed(PulseTimer);
-			CurveValue = PulseCurve->GetVectorValue(ElapsedTime);
-		}
-		break;
-
-	case EItemState::EIS_EquipInterping:
-		if (InterpPulseCurve)
-		{
-			ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
-			CurveValue = InterpPulseCurve->GetVectorValue(ElapsedTime);
-		}
-		break;
+		PulseSubsystem->RegisterItem(this);
 	}
-
-	// Extra check is needed becuase default weapon was glowing even though it is in equipped state
-	if ((ItemState == EItemState::EIS_EquipInterping || ItemState == EItemState::EIS_Pickup) && DynamicMaterialInstance)
+	else
 	{
-		DynamicMaterialInstance->SetScalarParameterValue(TEXT("GlowBlendAlpha"), CurveValue.X * GlowBlendAlpha);
-		DynamicMaterialInstance->SetScalarParameterValue(TEXT("FresnelExponent"), CurveValue.Y * FresnelExponent);
-		DynamicMaterialInstance->SetScalarParameterValue(TEXT("FrenselReflectionFraction"), CurveValue.X * FrenselReflectionFraction);
+		PulseSubsystem->UnregisterItem(this);
 	}
 }
 
+void AItem::SetSignificance(EItemSignificance NewSignificance, bool bNewInRelevanceRange)
+{
+	if (Significance == NewSignificance && bInRelevanceRange == bNewInRelevanceRange) return;
+
+	Significance = NewSignificance;
+	bInRelevanceRange = bNewInRelevanceRange;
+	ApplySignificance();
+}
+
+void AItem::ApplySignificance()
+{
+	// Held and interping items always get full fidelity
+	const EItemSignificance EffectiveSignificance{ ItemState == EItemState::EIS_Pickup ? Significance : EItemSignificance::High };
+
+	PickupWidget->SetComponentTickEnabled(EffectiveSignificance == EItemSignificance::High);
+	AreaSphere->SetGenerateOverlapEvents(EffectiveSignificance != EItemSignificance::Low);
+	UpdatePulseRegistration();
+}
+
 
 void AItem::EnableCustomDepth()
 {
@@ -571,4 +596,51 @@ void AItem::InitializeCustomDepth()
 	DisableCustomDepth();
 }
 
+void AItem::WritePickupRecord(FPickupRecord& Record) const
+{
+	Record.Transform = GetActorTransform();
+	Record.Rarity = ItemRarity;
+	Record.AmmoCount = ItemAmount;
+}
+
+void AItem::ReadPickupRecord(const FPickupRecord& Record)
+{
+	SetActorTransform(Record.Transform, false, nullptr, ETeleportType::ResetPhysics);
+	ItemRarity = Record.Rarity;
+	ItemAmount = Record.AmmoCount;
+
+	// Pooled actors can come back as a different rarity (and weapon type)
+	OnConstruction(GetActorTransform());
+}
+
+void AItem::SetPooled(bool bPooled)
+{
+	UWorld* World = GetWorld();
+	UItemSignificanceSubsystem* SignificanceSubsystem = World ? World->GetSubsystem<UItemSignificanceSubsystem>() : nullptr;
+
+	if (bPooled)
+	{
+		// Lowest tier first so weapons release their assets
+		SetSignificance(EItemSignificance::Low, false);
+		if (SignificanceSubsystem)
+		{
+			SignificanceSubsystem->UnregisterItem(this);
+		}
+		if (UItemInterpSubsystem* InterpSubsystem = World ? World->GetSubsystem<UItemInterpSubsystem>() : nullptr)
+		{
+			InterpSubsystem->RemoveItem(this);
+		}
+		PickupWidget->SetVisibility(false);
+	}
+	else
+	{
+		SetItemState(EItemState::EIS_Pickup);
+		if (SignificanceSubsystem)
+		{
+			SignificanceSubsystem->RegisterItem(this);
+		}
+	}
 
+	SetActorHiddenInGame(bPooled);
+	SetActorEnableCollision(!bPooled);
+}
@@ -7,6 +7,8 @@
 #include "Engine/DataTable.h"
 #include "Item.generated.h"
 
+enum class EItemSignificance : uint8;
+
 UENUM(BlueprintType)
 enum class EItemRarity : uint8
 {
@@ -73,13 +75,12 @@ public:
 	// Sets default values for this actor's properties
 	AItem();
 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	UFUNCTION()
 	void OnSphereBeginOverlap(
 		UPrimitiveComponent* OverlappedComponent,
@@ -105,19 +106,23 @@ protected:
 	/* Call back function to finish interping after the interping timer is done */
 	void EndItemInterpTimer();
 
-	/* Function to handle the item interpolation when picking up and item */
-	void InterpolateItemLocation(float DeltaTime);
-
 	/* Function to determine item interp location from shooter character InterpLocations array */
 	FVector GetInterpLocation();
 
 	/* C++ verison of construction strip in blueprint, called when item is changed or moved */
 	virtual void OnConstruction(const FTransform& Transform) override;
 
-	/* Pulse Effect Functions */
-	void StartPulseTimer();
-	void ResetPulseTimer();
-	void UpdatePulseParameters();
+	/* Adds or removes the item from the pulse subsystem depending on its state (only while interping, items on the ground pulse through their shared glow material) */
+	void UpdatePulseRegistration();
+
+	/* Sets the item's dynamic material instance (made from MaterialInstance, glowing in the rarity color) on MaterialIndex and turns the glow on */
+	void ApplyGlowMaterial();
+
+	/* Puts the glow material for the item state and bGlowEnabled on MaterialIndex */
+	void UpdateGlowMaterial();
+
+	/* Turns widget component tick and overlap events on or off for the current significance (only items on the ground are scaled back) */
+	virtual void ApplySignificance();
 
 
 private:
@@ -220,11 +225,14 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	int32 MaterialIndex;
 
-	/* Dynamic material instance that can be set/changed during runtime (thats why its dynamic) */
+	/*
+	* Glow material on MaterialIndex. In game worlds it is shared with every item of the same material instance and rarity (see UItemPulseSubsystem),
+	* an item interping to the character and items in editor worlds have their own
+	*/
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	UMaterialInstanceDynamic* DynamicMaterialInstance;
 
-	/* The material instance the dynamic material instance refers to */
+	/* The material instance the dynamic material instance is made from */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	UMaterialInstance* MaterialInstance;
 
@@ -236,11 +244,15 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	UCurveVector* InterpPulseCurve;
 
-	/* Timer Handle that controls the pulse effect */
-	FTimerHandle PulseTimer;
-
+	/* Length of one pulse on the ground (the phase is world time modulo this) */
 	float PulseDuration;
 
+	/* Glow turned on (on the ground and falling) or off (held) */
+	bool bGlowEnabled;
+
+	/* World time the item started interping to the character (phase of InterpPulseCurve) */
+	float ItemInterpStartTime;
+
 	UPROPERTY(EditAnywhere, Category = "Item Properties", meta = (AllowPrivateAccess = "true"))
 	float GlowBlendAlpha;
 
@@ -255,6 +267,14 @@ private:
 
 	bool bCanChangeCustomDepth;
 
+	/*--------------------------------------------------- Significance --------------------------------------------------------*/
+
+	/* Tier given by UItemSignificanceSubsystem */
+	EItemSignificance Significance;
+
+	/* True while a player is within the subsystem's relevance range (MediumSignificanceDistance), whether or not the item is rendered */
+	bool bInRelevanceRange;
+
 	/*--------------------------------------------------- Inventory --------------------------------------------------------*/
 
 	/* Image of the item for items in the inventory */
@@ -338,6 +358,13 @@ public:
 	FORCEINLINE void SetMaterialIndex(int32 MatIndex) { MaterialIndex = MatIndex; }
 
 	FORCEINLINE FLinearColor GetGlowColor() const { return GlowColor; }
+	FORCEINLINE EItemRarity GetItemRarity() const { return ItemRarity; }
+
+	FORCEINLINE UCurveVector* GetPulseCurve() const { return PulseCurve; }
+	FORCEINLINE float GetPulseDuration() const { return PulseDuration; }
+
+	/* Scale of the pulse curve value for GlowBlendAlpha, FresnelExponent and FrenselReflectionFraction */
+	FORCEINLINE FVector GetPulseScale() const { return FVector(GlowBlendAlpha, FresnelExponent, FrenselReflectionFraction); }
 
 	/* 
 	 * Force is a defualt variable so we can play the pickup/equip sound without limitation in certain cases
@@ -352,9 +379,45 @@ public:
 	virtual void DisableCustomDepth();
 	void InitializeCustomDepth();
 
+	/* Collision profiles (DefaultEngine.ini) of the pickup box and the area sphere */
+	static const FName PickupProfileName;
+	static const FName PickupAreaProfileName;
+
 	/* Enable and disable glow material */
 	void EnableGlowMaterial();
 	void DisableGlowMaterial();
 
+	/* Pulse curve and time on it while the item interps to the character, false otherwise (called by UItemPulseSubsystem) */
+	bool GetPulseSample(float WorldTime, class UCurveVector*& OutCurve, float& OutCurveTime) const;
+
+	/* Sets the glow scalars of the item's own material from a pulse curve value (called by UItemPulseSubsystem) */
+	void ApplyPulse(const FVector& CurveValue);
+
+	/* Fills the inputs of this frame's interpolation step, false if the item cannot interp (called by UItemInterpSubsystem) */
+	bool GetInterpJob(float WorldTime, struct FItemInterpJob& OutJob);
+
+	/* Applies a computed interpolation step (called by UItemInterpSubsystem) */
+	void ApplyInterpJob(const FItemInterpJob& Job);
+
+	/* Called by UItemSignificanceSubsystem, only does work when the tier or the relevance range changes */
+	void SetSignificance(EItemSignificance NewSignificance, bool bNewInRelevanceRange);
+
+	FORCEINLINE bool GetInRelevanceRange() const { return bInRelevanceRange; }
+
+	/* Static mesh drawn for the item while UPickupStoreSubsystem keeps it as a record, nullptr if it always stays an actor */
+	virtual class UStaticMesh* GetPickupProxyMesh() const { return nullptr; }
+
+	/* True once the item can be drawn in place of its proxy instance after being promoted from a record */
+	virtual bool IsPickupReady() const { return true; }
+
+	/* Writes what is needed to bring the item back into a pickup record (transform, rarity, amount) */
+	virtual void WritePickupRecord(struct FPickupRecord& Record) const;
+
+	/* Sets the item up from a pickup record and reruns its construction */
+	virtual void ReadPickupRecord(const FPickupRecord& Record);
+
+	/* Hides a stowed item and takes it out of every item subsystem, or brings it back as a pickup */
+	void SetPooled(bool bPooled);
+
 	
 };
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemInterpSubsystem.h"
+#include "Item.h"
+#include "Curves/CurveFloat.h"
+#include "Async/ParallelFor.h"
+
+UItemInterpSubsystem::UItemInterpSubsystem()
+{
+	// After the character has moved and the camera (carrying the interp components) has followed it
+	TickFunction.TickGroup = TG_PostUpdateWork;
+}
+
+void UItemInterpSubsystem::AddItem(AItem* Item)
+{
+	InterpingItems.AddUnique(Item);
+	SetTickEnabled(true);
+}
+
+void UItemInterpSubsystem::RemoveItem(AItem* Item)
+{
+	InterpingItems.RemoveSwap(Item);
+	SetTickEnabled(InterpingItems.Num() > 0);
+}
+
+void UItemInterpSubsystem::Tick(float DeltaTime)
+{
+	const float WorldTime{ GetWorld()->GetTimeSeconds() };
+
+	// Gather on the game thread (target locations come from the character's interp components)
+	Jobs.Reset(InterpingItems.Num());
+	for (AItem* Item : InterpingItems)
+	{
+		FItemInterpJob Job;
+		if (Item && Item->GetInterpJob(WorldTime, Job))
+		{
+			Jobs.Add(Job);
+		}
+	}
+
+	// Curves are only read here so every item can be computed in parallel
+	ParallelFor(Jobs.Num(), [this, DeltaTime](int32 Index)
+	{
+		ComputeJob(Jobs[Index], DeltaTime);
+	});
+
+	// One write back pass, no sweeps
+	for (const FItemInterpJob& Job : Jobs)
+	{
+		Job.Item->ApplyInterpJob(Job);
+	}
+}
+
+void UItemInterpSubsystem::ComputeJob(FItemInterpJob& Job, float DeltaTime)
+{
+	// Get the value of the item z curve at the elapsed time
+	const float CurveValue{ Job.ZCurve->GetFloatValue(Job.ElapsedTime) };
+
+	// All Z calculations are based on the Z of the start location
+	Job.Location = Job.StartLocation;
+
+	// Calculate the Delta Between the Item Location and the Camera Location so the item will rise
+	const float DeltaZ{ FMath::Abs(Job.TargetLocation.Z - Job.StartLocation.Z) };
+
+	// Linear Interpolation of the X and Y value
+	Job.Location.X = FMath::FInterpTo(Job.CurrentLocation.X, Job.TargetLocation.X, DeltaTime, 30.f);
+	Job.Location.Y = FMath::FInterpTo(Job.CurrentLocation.Y, Job.TargetLocation.Y, DeltaTime, 30.f);
+
+	// Add the delta to the item location
+	Job.Location.Z += CurveValue * DeltaZ;
+
+	// Shrink Item as the interpolation happens
+	Job.Scale = Job.ScaleCurve ? Job.ScaleCurve->GetFloatValue(Job.ElapsedTime) : 1.f;
+}
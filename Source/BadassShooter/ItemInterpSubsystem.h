@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "ItemInterpSubsystem.generated.h"
+
+/* One item's interpolation step: inputs gathered on the game thread, outputs computed on any thread */
+struct FItemInterpJob
+{
+	class AItem* Item{ nullptr };
+
+	/* Inputs */
+	FVector StartLocation{ FVector::ZeroVector };
+	FVector CurrentLocation{ FVector::ZeroVector };
+	FVector TargetLocation{ FVector::ZeroVector };
+	float ElapsedTime{ 0.f };
+	const class UCurveFloat* ZCurve{ nullptr };
+	const UCurveFloat* ScaleCurve{ nullptr };
+
+	/* Outputs */
+	FVector Location{ FVector::ZeroVector };
+	float Scale{ 1.f };
+};
+
+/**
+ * Moves every item that is interping to a character
+ * Locations and scales are computed for all items in a parallel pass and applied in one game thread pass without sweeps
+ * (interping items have collision disabled), so a pile of ammo picked up at once does not spike the frame
+ */
+UCLASS()
+class BADASSSHOOTER_API UItemInterpSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UItemInterpSubsystem();
+
+	void AddItem(AItem* Item);
+	void RemoveItem(AItem* Item);
+
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	/* Computes Location and Scale of a job (thread safe, only reads the job and the curves) */
+	static void ComputeJob(FItemInterpJob& Job, float DeltaTime);
+
+	/* Items that are interping */
+	UPROPERTY()
+	TArray<AItem*> InterpingItems;
+
+	/* Reused every frame */
+	TArray<FItemInterpJob> Jobs;
+};
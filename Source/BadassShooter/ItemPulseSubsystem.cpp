@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemPulseSubsystem.h"
+#include "Item.h"
+#include "Curves/CurveVector.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+UItemPulseSubsystem::UItemPulseSubsystem()
+{
+	// The glow is cosmetic so it runs with the other late FX work
+	TickFunction.TickGroup = TG_LastDemotable;
+}
+
+void UItemPulseSubsystem::RegisterItem(AItem* Item)
+{
+	PulsingItems.AddUnique(Item);
+	SetTickEnabled(true);
+}
+
+void UItemPulseSubsystem::UnregisterItem(AItem* Item)
+{
+	PulsingItems.RemoveSwap(Item);
+	SetTickEnabled(PulsingItems.Num() > 0 || SharedGlowMaterials.Num() > 0);
+}
+
+UMaterialInstanceDynamic* UItemPulseSubsystem::GetSharedGlowMaterial(const AItem* Item, bool bGlowEnabled)
+{
+	UMaterialInstance* MaterialInstance = Item->GetMaterialInstance();
+	FSharedGlowMaterial& Shared = SharedGlowMaterials.FindOrAdd(MakeTuple(FObjectKey(MaterialInstance), static_cast<uint8>(Item->GetItemRarity()), bGlowEnabled));
+	if (UMaterialInstanceDynamic* Material = Shared.Material.Get())
+	{
+		return Material;
+	}
+
+	UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(MaterialInstance, this);
+	Material->SetVectorParameterValue(FName(TEXT("FresnelColor")), Item->GetGlowColor());
+	Material->SetScalarParameterValue(TEXT("GlowBlendAlpha"), bGlowEnabled ? 0.f : 1.f);
+
+	Shared.Material = Material;
+	Shared.Curve = Item->GetPulseCurve();
+	Shared.Duration = Item->GetPulseDuration();
+	Shared.PulseScale = Item->GetPulseScale();
+	Shared.bGlowEnabled = bGlowEnabled;
+
+	SetTickEnabled(true);
+	return Material;
+}
+
+void UItemPulseSubsystem::SetPulseParameters(UMaterialInstanceDynamic* Material, const FVector& CurveValue, const FVector& PulseScale)
+{
+	// Parameter names are built once instead of on every pulse
+	static const FName GlowBlendAlphaName(TEXT("GlowBlendAlpha"));
+	static const FName FresnelExponentName(TEXT("FresnelExponent"));
+	static const FName FrenselReflectionFractionName(TEXT("FrenselReflectionFraction"));
+
+	Material->SetScalarParameterValue(GlowBlendAlphaName, CurveValue.X * PulseScale.X);
+	Material->SetScalarParameterValue(FresnelExponentName, CurveValue.Y * PulseScale.Y);
+	Material->SetScalarParameterValue(FrenselReflectionFractionName, CurveValue.X * PulseScale.Z);
+}
+
+void UItemPulseSubsystem::Tick(float DeltaTime)
+{
+	const float WorldTime{ GetWorld()->GetTimeSeconds() };
+
+	// Shared materials: one curve sample and one parameter update each, for every item on the ground that uses them
+	for (auto It = SharedGlowMaterials.CreateIterator(); It; ++It)
+	{
+		FSharedGlowMaterial& Shared = It.Value();
+		UMaterialInstanceDynamic* Material = Shared.Material.Get();
+		if (Material == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		const UCurveVector* Curve = Shared.Curve.Get();
+		if (!Shared.bGlowEnabled || Curve == nullptr || Shared.Duration <= 0.f) continue;
+
+		SetPulseParameters(Material, Curve->GetVectorValue(FMath::Fmod(WorldTime, Shared.Duration)), Shared.PulseScale);
+	}
+
+	// Sample pass: items that picked up at the same time share a phase so the curve is only evaluated once for them
+	PulseSamples.Reset();
+	ItemSampleIndices.Reset(PulsingItems.Num());
+	for (const AItem* Item : PulsingItems)
+	{
+		UCurveVector* Curve{ nullptr };
+		float CurveTime{ 0.f };
+		if (Item == nullptr || !Item->GetPulseSample(WorldTime, Curve, CurveTime))
+		{
+			ItemSampleIndices.Add(INDEX_NONE);
+			continue;
+		}
+
+		int32 SampleIndex{ PulseSamples.IndexOfByPredicate([Curve, CurveTime](const FPulseSample& Sample)
+		{
+			return Sample.Curve == Curve && Sample.CurveTime == CurveTime;
+		}) };
+
+		if (SampleIndex == INDEX_NONE)
+		{
+			SampleIndex = PulseSamples.Add({ Curve, CurveTime, Curve->GetVectorValue(CurveTime) });
+		}
+		ItemSampleIndices.Add(SampleIndex);
+	}
+
+	// Push pass: set the material parameters of every item in one go
+	for (int32 Index = 0; Index < PulsingItems.Num(); Index++)
+	{
+		if (ItemSampleIndices[Index] != INDEX_NONE)
+		{
+			PulsingItems[Index]->ApplyPulse(PulseSamples[ItemSampleIndices[Index]].Value);
+		}
+	}
+
+	SetTickEnabled(PulsingItems.Num() > 0 || SharedGlowMaterials.Num() > 0);
+}
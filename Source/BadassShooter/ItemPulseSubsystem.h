@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ItemPulseSubsystem.generated.h"
+
+/**
+ * Drives the glow pulse of every item on the ground or interping to the character
+ * Items on the ground share one glow material per material instance and rarity, pulsed in phase with world time (no timers),
+ * so the pulse costs one curve sample and one parameter update per shared material and not per item
+ * An item interping to the character pulses its own material from the time it was picked up
+ */
+UCLASS()
+class BADASSSHOOTER_API UItemPulseSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UItemPulseSubsystem();
+
+	/* Items interping to the character, pulsed through their own material */
+	void RegisterItem(class AItem* Item);
+	void UnregisterItem(AItem* Item);
+
+	/* Glow material shared by every item with the item's material instance and rarity, created on first use (glowing ones are pulsed) */
+	class UMaterialInstanceDynamic* GetSharedGlowMaterial(const AItem* Item, bool bGlowEnabled);
+
+	/* Sets the glow scalars of a material from a pulse curve value */
+	static void SetPulseParameters(UMaterialInstanceDynamic* Material, const FVector& CurveValue, const FVector& PulseScale);
+
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	/* Curve value at one phase, shared by every item on that curve and phase this frame */
+	struct FPulseSample
+	{
+		class UCurveVector* Curve;
+		float CurveTime;
+		FVector Value;
+	};
+
+	/* Shared glow material and the pulse it plays, from the first item that asked for it */
+	struct FSharedGlowMaterial
+	{
+		/* Weak so a material (and the weapon material it is made from) is collected once no item uses it */
+		TWeakObjectPtr<UMaterialInstanceDynamic> Material;
+		TWeakObjectPtr<class UCurveVector> Curve;
+		float Duration{ 0.f };
+		FVector PulseScale{ FVector::ZeroVector };
+		bool bGlowEnabled{ false };
+	};
+
+	/* Items that are currently pulsing their own material */
+	UPROPERTY()
+	TArray<AItem*> PulsingItems;
+
+	/* Shared glow materials by (material instance, rarity, glow enabled) */
+	TMap<TTuple<FObjectKey, uint8, bool>, FSharedGlowMaterial> SharedGlowMaterials;
+
+	/* Scratch arrays reused every frame */
+	TArray<FPulseSample> PulseSamples;
+	TArray<int32> ItemSampleIndices;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemSignificanceSubsystem.h"
+#include "Item.h"
+#include "GameFramework/PlayerController.h"
+
+UItemSignificanceSubsystem::UItemSignificanceSubsystem() :
+	HighSignificanceDistance(1'500.f),
+	MediumSignificanceDistance(5'000.f),
+	RecentlyRenderedTime(0.5f),
+	UpdateInterval(0.25f),
+	TimeSinceUpdate(0.f)
+{
+	// After the cameras moved this frame
+	TickFunction.TickGroup = TG_PostUpdateWork;
+}
+
+void UItemSignificanceSubsystem::RegisterItem(AItem* Item)
+{
+	Items.AddUnique(Item);
+	SetTickEnabled(true);
+}
+
+void UItemSignificanceSubsystem::UnregisterItem(AItem* Item)
+{
+	Items.RemoveSwap(Item);
+	SetTickEnabled(Items.Num() > 0);
+}
+
+void UItemSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < UpdateInterval) return;
+	TimeSinceUpdate = 0.f;
+
+	// View point of every player (on a server this includes remote players)
+	UWorld* World = GetWorld();
+	TArray<FVector, TInlineAllocator<4>> ViewLocations;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APlayerController* PlayerController = It->Get())
+		{
+			FVector ViewLocation;
+			FRotator ViewRotation;
+			PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+			ViewLocations.Add(ViewLocation);
+		}
+	}
+
+	for (AItem* Item : Items)
+	{
+		if (Item == nullptr) continue;
+
+		float ClosestDistanceSquared{ MAX_flt };
+		const FVector ItemLocation{ Item->GetActorLocation() };
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(ItemLocation, ViewLocation));
+		}
+
+		// Items only change what they do when the tier changes
+		const bool bInRelevanceRange{ ClosestDistanceSquared <= FMath::Square(MediumSignificanceDistance) };
+		Item->SetSignificance(GetSignificance(Item, ClosestDistanceSquared), bInRelevanceRange);
+	}
+}
+
+EItemSignificance UItemSignificanceSubsystem::GetSignificance(const AItem* Item, float DistanceSquared) const
+{
+	EItemSignificance Significance{ EItemSignificance::Low };
+	if (DistanceSquared <= FMath::Square(HighSignificanceDistance))
+	{
+		Significance = EItemSignificance::High;
+	}
+	else if (DistanceSquared <= FMath::Square(MediumSignificanceDistance))
+	{
+		Significance = EItemSignificance::Medium;
+	}
+
+	// Nothing is rendered on a dedicated server so view relevance only counts where there is a view
+	const bool bCheckRendered{ !IsRunningDedicatedServer() };
+	if (bCheckRendered && Significance != EItemSignificance::Low && !Item->WasRecentlyRendered(RecentlyRenderedTime))
+	{
+		Significance = Significance == EItemSignificance::High ? EItemSignificance::Medium : EItemSignificance::Low;
+	}
+
+	return Significance;
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "ItemSignificanceSubsystem.generated.h"
+
+/* How much fidelity a pickup gets */
+enum class EItemSignificance : uint8
+{
+	/* Full fidelity (widget component tick, overlaps) */
+	High,
+	/* Overlaps, no widget component tick */
+	Medium,
+	/* No widget component tick, no overlap events */
+	Low
+};
+
+/**
+ * Classifies every pickup into a significance tier by distance to the closest player view point and whether it was rendered recently
+ * Tier distances come from the Game config so they can be overridden per platform (e.g. Config/Android/AndroidGame.ini)
+ */
+UCLASS(config = Game)
+class BADASSSHOOTER_API UItemSignificanceSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UItemSignificanceSubsystem();
+
+	void RegisterItem(class AItem* Item);
+	void UnregisterItem(AItem* Item);
+
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	/* Tier of an item given the squared distance to the closest view point */
+	EItemSignificance GetSignificance(const AItem* Item, float DistanceSquared) const;
+
+	/* Items up to this distance from a player are High (has to be larger than the item area sphere radius) */
+	UPROPERTY(Config)
+	float HighSignificanceDistance;
+
+	/* Items up to this distance from a player are Medium, the rest are Low */
+	UPROPERTY(Config)
+	float MediumSignificanceDistance;
+
+	/* Items not rendered within this many seconds drop one tier (ignored on a dedicated server) */
+	UPROPERTY(Config)
+	float RecentlyRenderedTime;
+
+	/* Seconds between classifications */
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	float TimeSinceUpdate;
+
+	UPROPERTY()
+	TArray<AItem*> Items;
+};
@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PickupStoreSubsystem.h"
+#include "Item.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+UPickupStoreSubsystem::UPickupStoreSubsystem() :
+	PromoteDistance(1'200.f),
+	DemoteDistance(1'800.f),
+	UpdateInterval(0.25f),
+	MaxPooledItems(32),
+	TimeSinceUpdate(0.f),
+	ProxyActor(nullptr)
+{
+	// After the characters moved and items changed state this frame
+	TickFunction.TickGroup = TG_PostUpdateWork;
+}
+
+void UPickupStoreSubsystem::Deinitialize()
+{
+	Items.Reset();
+	PooledItems.Reset();
+	Records.Reset();
+	ProxyGroups.Reset();
+	ProxyGroupIndices.Reset();
+	PromotedRecords.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPickupStoreSubsystem::RegisterItem(AItem* Item)
+{
+	Items.AddUnique(Item);
+	SetTickEnabled(true);
+}
+
+void UPickupStoreSubsystem::UnregisterItem(AItem* Item)
+{
+	Items.RemoveSwap(Item);
+	PooledItems.RemoveSwap(Item);
+	OnItemReady(Item);
+	SetTickEnabled(Items.Num() > 0 || Records.Num() > 0);
+}
+
+void UPickupStoreSubsystem::OnItemReady(AItem* Item)
+{
+	int32 RecordIndex;
+	if (PromotedRecords.RemoveAndCopyValue(Item, RecordIndex))
+	{
+		RemoveRecord(RecordIndex);
+	}
+}
+
+void UPickupStoreSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < UpdateInterval) return;
+	TimeSinceUpdate = 0.f;
+
+	// Location of every player's pawn (the view point if there is no pawn)
+	UWorld* World = GetWorld();
+	TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (APlayerController* PlayerController = It->Get())
+		{
+			if (const APawn* Pawn = PlayerController->GetPawn())
+			{
+				PlayerLocations.Add(Pawn->GetActorLocation());
+			}
+			else
+			{
+				FVector ViewLocation;
+				FRotator ViewRotation;
+				PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+				PlayerLocations.Add(ViewLocation);
+			}
+		}
+	}
+
+	// Without players nothing is promoted or stowed (e.g. while the player pawn is being respawned)
+	if (PlayerLocations.Num() == 0) return;
+
+	auto ClosestDistanceSquared = [&PlayerLocations](const FVector& Location)
+	{
+		float DistanceSquared{ MAX_flt };
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(Location, PlayerLocation));
+		}
+		return DistanceSquared;
+	};
+
+	// Records first so an item stowed this update is not promoted in the same pass
+	const float PromoteDistanceSquared{ FMath::Square(PromoteDistance) };
+	TArray<int32, TInlineAllocator<16>> RecordsToPromote;
+	for (auto It = Records.CreateConstIterator(); It; ++It)
+	{
+		if (!It->bPromoted && ClosestDistanceSquared(It->Transform.GetLocation()) <= PromoteDistanceSquared)
+		{
+			RecordsToPromote.Add(It.GetIndex());
+		}
+	}
+	for (const int32 RecordIndex : RecordsToPromote)
+	{
+		PromoteRecord(RecordIndex);
+	}
+
+	// Back to front since stowed items are removed from the array
+	const float DemoteDistanceSquared{ FMath::Square(FMath::Max(DemoteDistance, PromoteDistance)) };
+	for (int32 Index = Items.Num() - 1; Index >= 0; Index--)
+	{
+		AItem* Item = Items[Index];
+		if (Item == nullptr || Item->IsPendingKill())
+		{
+			Items.RemoveAtSwap(Index);
+			continue;
+		}
+
+		// Only pickups lying on the ground, never items that are falling, interping or owned
+		if (Item->GetItemState() != EItemState::EIS_Pickup) continue;
+		if (ClosestDistanceSquared(Item->GetActorLocation()) <= DemoteDistanceSquared) continue;
+
+		StowItem(Item);
+	}
+
+	SetTickEnabled(Items.Num() > 0 || Records.Num() > 0);
+}
+
+bool UPickupStoreSubsystem::StowItem(AItem* Item)
+{
+	UStaticMesh* ProxyMesh = Item->GetPickupProxyMesh();
+	if (ProxyMesh == nullptr) return false;
+
+	// Stowed again before it was ever drawn, its old instance goes first
+	OnItemReady(Item);
+
+	FPickupRecord Record;
+	Record.ItemClass = Item->GetClass();
+	Item->WritePickupRecord(Record);
+	RecordClasses.AddUnique(Item->GetClass());
+
+	Record.ProxyGroupIndex = FindOrAddProxyGroup(ProxyMesh);
+	FProxyGroup& ProxyGroup = ProxyGroups[Record.ProxyGroupIndex];
+	Record.InstanceIndex = ProxyGroup.Component->AddInstanceWorldSpace(Record.Transform);
+	ProxyGroup.InstanceRecords.Add(Records.Add(MoveTemp(Record)));
+
+	// The actor is removed from Items before it can be destroyed (EndPlay unregisters it again)
+	Items.RemoveSwap(Item);
+	if (PooledItems.Num() < MaxPooledItems)
+	{
+		Item->SetPooled(true);
+		PooledItems.Add(Item);
+	}
+	else
+	{
+		Item->Destroy();
+	}
+	return true;
+}
+
+void UPickupStoreSubsystem::PromoteRecord(int32 RecordIndex)
+{
+	const FPickupRecord Record{ Records[RecordIndex] };
+	AItem* Item = AcquireItem(Record.ItemClass, Record.Transform);
+	if (Item == nullptr)
+	{
+		RemoveRecord(RecordIndex);
+		return;
+	}
+
+	Item->ReadPickupRecord(Record);
+	Item->SetPooled(false);
+	RegisterItem(Item);
+
+	// Keep drawing the instance until the actor can be drawn so the pickup does not pop out
+	if (Item->IsPickupReady())
+	{
+		RemoveRecord(RecordIndex);
+	}
+	else
+	{
+		Records[RecordIndex].bPromoted = true;
+		PromotedRecords.Add(Item, RecordIndex);
+	}
+}
+
+void UPickupStoreSubsystem::RemoveRecord(int32 RecordIndex)
+{
+	RemoveInstance(Records[RecordIndex]);
+	Records.RemoveAt(RecordIndex);
+}
+
+AItem* UPickupStoreSubsystem::AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform)
+{
+	for (int32 Index = PooledItems.Num() - 1; Index >= 0; Index--)
+	{
+		AItem* Item = PooledItems[Index];
+		if (Item && !Item->IsPendingKill() && Item->GetClass() == ItemClass)
+		{
+			PooledItems.RemoveAtSwap(Index);
+			return Item;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AItem>(ItemClass, Transform, SpawnParameters);
+}
+
+int32 UPickupStoreSubsystem::FindOrAddProxyGroup(UStaticMesh* Mesh)
+{
+	if (const int32* GroupIndex = ProxyGroupIndices.Find(Mesh))
+	{
+		return *GroupIndex;
+	}
+
+	// One transient actor holds every proxy component (at the origin, instances are placed in world space)
+	if (ProxyActor == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		ProxyActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+		USceneComponent* Root = NewObject<USceneComponent>(ProxyActor, TEXT("Root"));
+		ProxyActor->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	// Proxies are only drawn, players are promoted to the full actor long before they can touch them
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(ProxyActor);
+	Component->SetStaticMesh(Mesh);
+	Component->SetMobility(EComponentMobility::Movable);
+	Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Component->SetCanEverAffectNavigation(false);
+	Component->SetupAttachment(ProxyActor->GetRootComponent());
+	Component->RegisterComponent();
+
+	FProxyGroup ProxyGroup;
+	ProxyGroup.Component = Component;
+	const int32 GroupIndex{ ProxyGroups.Add(ProxyGroup) };
+	ProxyGroupIndices.Add(Mesh, GroupIndex);
+	return GroupIndex;
+}
+
+void UPickupStoreSubsystem::RemoveInstance(const FPickupRecord& Record)
+{
+	if (!ProxyGroups.IsValidIndex(Record.ProxyGroupIndex)) return;
+
+	FProxyGroup& ProxyGroup = ProxyGroups[Record.ProxyGroupIndex];
+	const int32 LastInstanceIndex{ ProxyGroup.InstanceRecords.Num() - 1 };
+	if (!ProxyGroup.InstanceRecords.IsValidIndex(Record.InstanceIndex)) return;
+
+	// Removing the last instance does not shift any other instance
+	if (Record.InstanceIndex != LastInstanceIndex)
+	{
+		const int32 MovedRecordIndex{ ProxyGroup.InstanceRecords[LastInstanceIndex] };
+		FPickupRecord& MovedRecord = Records[MovedRecordIndex];
+		ProxyGroup.Component->UpdateInstanceTransform(Record.InstanceIndex, MovedRecord.Transform, true, false, true);
+		MovedRecord.InstanceIndex = Record.InstanceIndex;
+		ProxyGroup.InstanceRecords[Record.InstanceIndex] = MovedRecordIndex;
+	}
+
+	ProxyGroup.Component->RemoveInstance(LastInstanceIndex);
+	ProxyGroup.InstanceRecords.RemoveAt(LastInstanceIndex);
+}
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "AmmoType.h"
+#include "WeaponType.h"
+#include "PickupStoreSubsystem.generated.h"
+
+enum class EItemRarity : uint8;
+
+/* A pickup lying in the world without an actor (drawn as one instance of its proxy mesh) */
+struct FPickupRecord
+{
+	FTransform Transform;
+
+	/* Class the actor is spawned or pooled from when the record is promoted */
+	TSubclassOf<class AItem> ItemClass;
+
+	EItemRarity Rarity;
+	EWeaponType WeaponType{ EWeaponType::EWT_AssaultRifle };
+	EAmmoType AmmoType{ EAmmoType::EAT_AR };
+
+	/* Ammo in the magazine for weapons, ammo in the box for ammo */
+	int32 AmmoCount{ 0 };
+
+	/* Proxy group and instance drawing the record */
+	int32 ProxyGroupIndex{ INDEX_NONE };
+	int32 InstanceIndex{ INDEX_NONE };
+
+	/* True once an actor was promoted from the record, the instance is kept until the actor can be drawn */
+	bool bPromoted{ false };
+};
+
+/**
+ * World level store of pickups nobody is near
+ * Pickups further than DemoteDistance from every player are turned into records and their actors are pooled,
+ * records are drawn through one instanced static mesh component per proxy mesh
+ * A record is turned back into a full AWeapon/AAmmo (from the pool if there is a matching one) once a player is within PromoteDistance,
+* its instance is drawn until the actor is ready (weapons wait for their streamed assets)
+ * Items without a proxy mesh (see AItem::GetPickupProxyMesh) always stay actors
+ */
+UCLASS(config = Game)
+class BADASSSHOOTER_API UPickupStoreSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UPickupStoreSubsystem();
+
+	virtual void Deinitialize() override;
+
+	/* Called by items when they begin/end play */
+	void RegisterItem(AItem* Item);
+	void UnregisterItem(AItem* Item);
+
+	/* Called by items once they can be drawn (see AItem::IsPickupReady), removes the instance kept for a promoted item */
+	void OnItemReady(AItem* Item);
+
+	virtual void Tick(float DeltaTime) override;
+
+	FORCEINLINE int32 GetNumRecords() const { return Records.Num(); }
+
+private:
+	/* Instanced static mesh component and the record of every instance */
+	struct FProxyGroup
+	{
+		class UInstancedStaticMeshComponent* Component{ nullptr };
+		TArray<int32> InstanceRecords;
+	};
+
+	/* Replaces a pickup actor with a record and pools (or destroys) the actor, false if the item has no proxy mesh */
+	bool StowItem(AItem* Item);
+
+	/* Replaces a record with a pickup actor, the record stays until the actor is ready to be drawn */
+	void PromoteRecord(int32 RecordIndex);
+
+	/* Removes a record and its instance */
+	void RemoveRecord(int32 RecordIndex);
+
+	/* Pooled actor of the class, or a newly spawned one */
+	AItem* AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform);
+
+	/* Index of the proxy group drawing the mesh, created on first use */
+	int32 FindOrAddProxyGroup(class UStaticMesh* Mesh);
+
+	/* Removes a record's instance, the last instance of the group is moved into its slot */
+	void RemoveInstance(const FPickupRecord& Record);
+
+	/* Players within PromoteDistance promote records, pickups further than DemoteDistance from every player are stowed */
+	UPROPERTY(Config)
+	float PromoteDistance;
+
+	/* Larger than PromoteDistance so a player walking along the edge does not swap a pickup back and forth */
+	UPROPERTY(Config)
+	float DemoteDistance;
+
+	/* Seconds between updates */
+	UPROPERTY(Config)
+	float UpdateInterval;
+
+	/* Upper limit on pooled actors, stowed actors beyond it are destroyed */
+	UPROPERTY(Config)
+	int32 MaxPooledItems;
+
+	float TimeSinceUpdate;
+
+	/* Pickup actors in play (stowed when they are pickups nobody is near) */
+	UPROPERTY()
+	TArray<AItem*> Items;
+
+	/* Hidden actors waiting to be promoted again */
+	UPROPERTY()
+	TArray<AItem*> PooledItems;
+
+	/* Item classes of the records (kept loaded for as long as the store exists) */
+	UPROPERTY()
+	TArray<UClass*> RecordClasses;
+
+	/* Holds the proxy components */
+	UPROPERTY()
+	AActor* ProxyActor;
+
+	/* Records indexed by instance through FProxyGroup::InstanceRecords, indices stay valid when others are removed */
+	TSparseArray<FPickupRecord> Records;
+
+	TArray<FProxyGroup> ProxyGroups;
+	TMap<UStaticMesh*, int32> ProxyGroupIndices;
+
+	/* Record of every promoted item that is not ready to be drawn yet */
+	TMap<const AItem*, int32> PromotedRecords;
+};
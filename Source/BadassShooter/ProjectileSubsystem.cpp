@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSubsystem.h"
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+#include "BadassShooter.h"
+#include "TraceBudget.h"
+
+UProjectileSubsystem::UProjectileSubsystem()
+{
+	// After every character fired this frame
+	TickFunction.TickGroup = TG_PostUpdateWork;
+}
+
+void UProjectileSubsystem::FireProjectile(const FVector& Location, const FVector& Velocity, float GravityScale, float Lifetime, AActor* Instigator, UParticleSystem* ImpactParticles)
+{
+	if (Projectiles.Num() >= MaxProjectiles)
+	{
+		// Removal swaps projectiles around so the array is not in firing order, the one closest to expiring makes room
+		int32 OldestIndex{ 0 };
+		for (int32 Index = 1; Index < Projectiles.Num(); Index++)
+		{
+			if (Projectiles[Index].TimeLeft < Projectiles[OldestIndex].TimeLeft)
+			{
+				OldestIndex = Index;
+			}
+		}
+		Projectiles.RemoveAtSwap(OldestIndex, 1, false);
+	}
+
+	// Its first sweep runs later this frame
+	FTraceBudget::AddCombatQueries(GetWorld());
+	SetTickEnabled(true);
+
+	FProjectile& Projectile = Projectiles.AddDefaulted_GetRef();
+	Projectile.Location = Location;
+	Projectile.Velocity = Velocity;
+	Projectile.GravityScale = GravityScale;
+	Projectile.TimeLeft = Lifetime;
+	Projectile.Instigator = Instigator;
+	Projectile.ImpactParticles = ImpactParticles;
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+	const int32 NumProjectiles{ Projectiles.Num() };
+	const FVector Gravity{ 0.f, 0.f, World->GetGravityZ() };
+
+	SweepHits.SetNum(NumProjectiles, false);
+	SweepHitFlags.SetNumZeroed(NumProjectiles, false);
+
+	// Weak pointers can only be resolved on the game thread
+	SweepIgnoredActors.SetNum(NumProjectiles, false);
+	for (int32 Index = 0; Index < NumProjectiles; Index++)
+	{
+		SweepIgnoredActors[Index] = Projectiles[Index].Instigator.Get();
+	}
+
+	// Advance every projectile and sweep the segment it travelled this frame (scene queries are read only so they can run in parallel)
+	ParallelFor(NumProjectiles, [this, World, &Gravity, DeltaTime](int32 Index)
+	{
+		FProjectile& Projectile = Projectiles[Index];
+		const FVector Start{ Projectile.Location };
+		Projectile.Velocity += Gravity * Projectile.GravityScale * DeltaTime;
+		const FVector End{ Start + Projectile.Velocity * DeltaTime };
+		Projectile.TimeLeft -= DeltaTime;
+
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false, SweepIgnoredActors[Index]);
+		FHitResult& Hit = SweepHits[Index];
+		SweepHitFlags[Index] = World->LineTraceSingleByChannel(Hit, Start, End, ECC_WeaponFire, QueryParams);
+		Projectile.Location = SweepHitFlags[Index] ? Hit.Location : End;
+	});
+
+	// Impacts and removal on the game thread (back to front so RemoveAtSwap does not skip anything)
+	for (int32 Index = NumProjectiles - 1; Index >= 0; --Index)
+	{
+		const FProjectile& Projectile = Projectiles[Index];
+		if (SweepHitFlags[Index])
+		{
+			if (UParticleSystem* ImpactParticles = Projectile.ImpactParticles.Get())
+			{
+				UGameplayStatics::SpawnEmitterAtLocation(World, ImpactParticles, SweepHits[Index].Location, FRotator::ZeroRotator, FVector(1.f), true, EPSCPoolMethod::AutoRelease);
+			}
+			Projectiles.RemoveAtSwap(Index, 1, false);
+		}
+		else if (Projectile.TimeLeft <= 0.f)
+		{
+			Projectiles.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	// The subsystem ticks after the actors, so next frame's sweeps are charged now where item focus and footsteps will see them
+	FTraceBudget::ReserveCombatQueries(World, Projectiles.Num());
+	SetTickEnabled(Projectiles.Num() > 0);
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "ProjectileSubsystem.generated.h"
+
+/* A single bullet in flight (plain data, no actor) */
+struct FProjectile
+{
+	FVector Location;
+	FVector Velocity;
+
+	/* Multiplier for world gravity (bullet drop) */
+	float GravityScale;
+
+	/* Seconds left before the projectile is removed without hitting anything */
+	float TimeLeft;
+
+	/* Actor that fired the projectile (ignored by its sweeps) */
+	TWeakObjectPtr<AActor> Instigator;
+
+	/* Particles spawned where the projectile hits */
+	TWeakObjectPtr<UParticleSystem> ImpactParticles;
+};
+
+/**
+ * Owns every projectile in flight in one contiguous array and advances them all in a single pass per frame
+ * Segment sweeps run in parallel, impacts and removal happen afterwards on the game thread
+ */
+UCLASS()
+class BADASSSHOOTER_API UProjectileSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UProjectileSubsystem();
+
+	/* Adds a projectile to the pool */
+	void FireProjectile(const FVector& Location, const FVector& Velocity, float GravityScale, float Lifetime, AActor* Instigator, UParticleSystem* ImpactParticles);
+
+	FORCEINLINE int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	/* Projectiles in flight */
+	TArray<FProjectile> Projectiles;
+
+	/* Per projectile sweep results of the current frame (kept to avoid reallocating every frame) */
+	TArray<FHitResult> SweepHits;
+	TArray<uint8> SweepHitFlags;
+
+	/* Instigator of every projectile, resolved on the game thread before the parallel sweeps */
+	TArray<const AActor*> SweepIgnoredActors;
+
+	/* Upper limit on projectiles in flight (the projectile closest to expiring is dropped to make room for a new one) */
+	int32 MaxProjectiles{ 8192 };
+};
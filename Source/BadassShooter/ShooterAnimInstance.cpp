@@ -20,20 +20,13 @@ UShooterAnimInstance::UShooterAnimInstance() :
 	MovementOffsetYaw(0.f),
 	MovementOffsetYawLastFrame(0.f),
 	// Turn in Place Variables and Aim Offset
-	TIPCharacterYaw(0.f),
-	TIPCharacterYawLastFrame(0.f),
 	RootYawOffset(0.f),
-	RotationCurve(0.f),
-	RotationCurveLastFrame(0.f),
 	AimingPitch(0.f),
 	// Character State and Leaning
 	OffsetState(EOffsetState::EOS_NonCombat),
-	CharacterLean(FRotator(0.f)),
-	CharacterLeanLastFrame(FRotator(0.f)),
 	LeanYawDelta(0.f),
 	// Recoil Variables
 	RecoilWeight(0.f),
-	bIsTurning(false),
 	EquippedWeaponType(EWeaponType::EWT_AssaultRifle),
 	bShouldUseFABRIK(false)
 {}
@@ -44,98 +37,145 @@ void UShooterAnimInstance::NativeInitializeAnimation()
 }
 
 void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
+{
+}
+
+FAnimInstanceProxy* UShooterAnimInstance::CreateAnimInstanceProxy()
+{
+	return new FShooterAnimInstanceProxy(this);
+}
+
+void UShooterAnimInstance::TakeSnapshot(FShooterAnimSnapshot& OutSnapshot)
 {
 	if (ShooterCharacter == nullptr)
 	{
 		ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
 	}
-	if (ShooterCharacter)
+
+	OutSnapshot.bHasCharacter = ShooterCharacter != nullptr;
+	if (ShooterCharacter == nullptr) return;
+
+	const UCharacterMovementComponent* Movement = ShooterCharacter->GetCharacterMovement();
+	OutSnapshot.Velocity = Movement->Velocity;
+	OutSnapshot.Acceleration = Movement->GetCurrentAcceleration();
+	OutSnapshot.bIsInAir = Movement->IsFalling();
+	OutSnapshot.AimRotation = ShooterCharacter->GetBaseAimRotation();
+	OutSnapshot.ActorRotation = ShooterCharacter->GetActorRotation();
+
+	const ECombatState CombatState{ ShooterCharacter->GetCombatState() };
+	OutSnapshot.bIsReloading = CombatState == ECombatState::ECS_Reloading;
+	OutSnapshot.bIsEquipping = CombatState == ECombatState::ECS_Equipping;
+	OutSnapshot.bShouldUseFABRIK = CombatState == ECombatState::ECS_Unoccupied || CombatState == ECombatState::ECS_FireTImerInProgress;
+
+	OutSnapshot.bIsAiming = ShooterCharacter->GetIsAiming();
+	OutSnapshot.bIsCrouching = ShooterCharacter->GetIsCrouching();
+	OutSnapshot.bIsInCombatPose = ShooterCharacter->GetIsInCombatPose();
+
+	OutSnapshot.bHasWeapon = ShooterCharacter->GetEquippedWeapon() != nullptr;
+	if (OutSnapshot.bHasWeapon)
 	{
-		// Determine if crouching
-		bIsCrouching = ShooterCharacter->GetIsCrouching();
+		OutSnapshot.WeaponType = ShooterCharacter->GetEquippedWeapon()->GetWeaponType();
+	}
+}
 
-		// Determine if reloading
-		bIsReloading = ShooterCharacter->GetCombatState() == ECombatState::ECS_Reloading;
+void UShooterAnimInstance::CopyProperties(const FShooterAnimProperties& Properties)
+{
+	CharacterSpeed = Properties.CharacterSpeed;
+	bIsInAir = Properties.bIsInAir;
+	bIsMoving = Properties.bIsMoving;
+	bIsAiming = Properties.bIsAiming;
+	bIsInCombatPose = Properties.bIsInCombatPose;
+	bIsCrouching = Properties.bIsCrouching;
+	bIsReloading = Properties.bIsReloading;
+	bIsEquipping = Properties.bIsEquipping;
+	bShouldUseFABRIK = Properties.bShouldUseFABRIK;
+	MovementOffsetYaw = Properties.MovementOffsetYaw;
+	MovementOffsetYawLastFrame = Properties.MovementOffsetYawLastFrame;
+	OffsetState = Properties.OffsetState;
+	EquippedWeaponType = Properties.EquippedWeaponType;
+	RootYawOffset = Properties.RootYawOffset;
+	AimingPitch = Properties.AimingPitch;
+	RecoilWeight = Properties.RecoilWeight;
+	LeanYawDelta = Properties.LeanYawDelta;
+}
 
-		// Determine if Equipping
-		bIsEquipping = ShooterCharacter->GetCombatState() == ECombatState::ECS_Equipping;
+void FShooterAnimProperties::Update(const FShooterAnimSnapshot& Snapshot, float TurningCurveValue, float RotationCurveValue, float DeltaTime)
+{
+	if (!Snapshot.bHasCharacter) return;
 
-		// Determine if FABRIK nodes should be used
-		bShouldUseFABRIK = ShooterCharacter->GetCombatState() == ECombatState::ECS_Unoccupied || ShooterCharacter->GetCombatState() == ECombatState::ECS_FireTImerInProgress;
+	// Determine if crouching
+	bIsCrouching = Snapshot.bIsCrouching;
 
-		// Determine MovementSpeed 
-		FVector Velocity = ShooterCharacter->GetCharacterMovement()->Velocity;
-		Velocity.Z = 0;
-		CharacterSpeed = Velocity.Size(); // Returns magnitude of lateral velocity vector
+	// Determine if reloading
+	bIsReloading = Snapshot.bIsReloading;
 
-		// Determine bIsInAir
-		bIsInAir = ShooterCharacter->GetCharacterMovement()->IsFalling();
+	// Determine if Equipping
+	bIsEquipping = Snapshot.bIsEquipping;
 
-		// Determine bIsMoving
-		if (ShooterCharacter->GetCharacterMovement()->GetCurrentAcceleration().Size() > 0.f)
-		{
-			bIsMoving = true;
-		}
-		else
-		{
-			bIsMoving = false;
-		}
+	// Determine if FABRIK nodes should be used
+	bShouldUseFABRIK = Snapshot.bShouldUseFABRIK;
 
-		// Determine if Aiming
-		bIsAiming = ShooterCharacter->GetIsAiming();
+	// Determine MovementSpeed 
+	FVector Velocity = Snapshot.Velocity;
+	Velocity.Z = 0;
+	CharacterSpeed = Velocity.Size(); // Returns magnitude of lateral velocity vector
 
-		bIsInCombatPose = ShooterCharacter->GetIsInCombatPose();
+	// Determine bIsInAir
+	bIsInAir = Snapshot.bIsInAir;
 
-		// Determine the yaw direction of the character movement
-		FRotator AimRotation = ShooterCharacter->GetBaseAimRotation();
-		FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(ShooterCharacter->GetVelocity());
-		MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation).Yaw;;
+	// Determine bIsMoving
+	bIsMoving = Snapshot.Acceleration.Size() > 0.f;
 
-		if (ShooterCharacter->GetVelocity().Size() > 0)
-		{
-			MovementOffsetYawLastFrame = MovementOffsetYaw;
-		}
+	// Determine if Aiming
+	bIsAiming = Snapshot.bIsAiming;
 
-		if (bIsReloading)
-		{
-			OffsetState = EOffsetState::EOS_Reloading;
-		}
-		else if(bIsInAir)
-		{
-			OffsetState = EOffsetState::EOS_Air;
-		}
-		else if (bIsAiming || bIsInCombatPose)
-		{
-			OffsetState = EOffsetState::EOS_Combat;
-		}
-		else
-		{
-			OffsetState = EOffsetState::EOS_NonCombat;
-		}
+	bIsInCombatPose = Snapshot.bIsInCombatPose;
 
-		if (ShooterCharacter->GetEquippedWeapon())
-		{
-			EquippedWeaponType = ShooterCharacter->GetEquippedWeapon()->GetWeaponType();
-		}
+	// Determine the yaw direction of the character movement
+	const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Snapshot.Velocity);
+	MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, Snapshot.AimRotation).Yaw;
+
+	if (Snapshot.Velocity.Size() > 0)
+	{
+		MovementOffsetYawLastFrame = MovementOffsetYaw;
+	}
+
+	if (bIsReloading)
+	{
+		OffsetState = EOffsetState::EOS_Reloading;
+	}
+	else if(bIsInAir)
+	{
+		OffsetState = EOffsetState::EOS_Air;
+	}
+	else if (bIsAiming || bIsInCombatPose)
+	{
+		OffsetState = EOffsetState::EOS_Combat;
+	}
+	else
+	{
+		OffsetState = EOffsetState::EOS_NonCombat;
 	}
 
-	TurnInPlace();
-	Lean(DeltaTime);
+	if (Snapshot.bHasWeapon)
+	{
+		EquippedWeaponType = Snapshot.WeaponType;
+	}
 
+	TurnInPlace(Snapshot, TurningCurveValue, RotationCurveValue);
+	Lean(Snapshot, DeltaTime);
 }
 
-void UShooterAnimInstance::TurnInPlace()
+void FShooterAnimProperties::TurnInPlace(const FShooterAnimSnapshot& Snapshot, float TurningCurveValue, float RotationCurveValue)
 {
-	if (ShooterCharacter == nullptr) return;
-
-	AimingPitch = ShooterCharacter->GetBaseAimRotation().Pitch;
+	AimingPitch = Snapshot.AimRotation.Pitch;
 
 	if (CharacterSpeed > 0 || bIsInAir)
 	{
 		// Do not do any calcuations if character is moving or jumping.
 		// We do not want to turn in place under these conditions
 		RootYawOffset = 0.f;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
 		RotationCurveLastFrame = 0.f;
 		RotationCurve = 0.f;
@@ -143,17 +183,16 @@ void UShooterAnimInstance::TurnInPlace()
 	else
 	{
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 		const float TIPYawDelta{ TIPCharacterYaw - TIPCharacterYawLastFrame };
 
 		RootYawOffset = UKismetMathLibrary::NormalizeAxis(RootYawOffset - TIPYawDelta); // Negative of Character Yaw (Description in .h file)
 
-		const float Turning{ GetCurveValue(TEXT("Turning")) };
-		if (Turning > 0)
+		if (TurningCurveValue > 0)
 		{
 			bIsTurning = true;
 			RotationCurveLastFrame = RotationCurve;
-			RotationCurve = GetCurveValue(TEXT("Rotation"));
+			RotationCurve = RotationCurveValue;
 			const float DeltaRotation{ RotationCurve - RotationCurveLastFrame };
 
 			/* RootYawOffset > 0 : LEFT TURN       RootYawOffset < 0 : RIGHT TURN */
@@ -214,12 +253,12 @@ void UShooterAnimInstance::TurnInPlace()
 	
 }
 
-void UShooterAnimInstance::Lean(float DeltaTime)
+void FShooterAnimProperties::Lean(const FShooterAnimSnapshot& Snapshot, float DeltaTime)
 {
-	if (ShooterCharacter == nullptr) return;
+	if (DeltaTime <= 0.f) return;
 
 	CharacterLeanLastFrame = CharacterLean;
-	CharacterLean = ShooterCharacter->GetActorRotation();
+	CharacterLean = Snapshot.ActorRotation;
 	
 	// Interp lean value to the targe delta betweeen the lean character yaws
 	const FRotator Delta{ UKismetMathLibrary::NormalizedDeltaRotator(CharacterLean, CharacterLeanLastFrame) };
@@ -231,4 +270,44 @@ void UShooterAnimInstance::Lean(float DeltaTime)
 
 }
 
+/*---- ANIM INSTANCE PROXY ----*/
+
+void FShooterAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+	ShooterAnimInstance = Cast<UShooterAnimInstance>(InAnimInstance);
+}
+
+void FShooterAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	if (ShooterAnimInstance)
+	{
+		ShooterAnimInstance->TakeSnapshot(Snapshot);
+	}
+}
 
+void FShooterAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	// Curves of the last evaluated pose, the names are built once instead of every update
+	static const FName TurningCurveName(TEXT("Turning"));
+	static const FName RotationCurveName(TEXT("Rotation"));
+	const TMap<FName, float>& Curves = GetAnimationCurves(EAnimCurveType::AttributeCurve);
+	const float* TurningCurveValue = Curves.Find(TurningCurveName);
+	const float* RotationCurveValue = Curves.Find(RotationCurveName);
+
+	Properties.Update(
+		Snapshot,
+		TurningCurveValue ? *TurningCurveValue : 0.f,
+		RotationCurveValue ? *RotationCurveValue : 0.f,
+		DeltaSeconds);
+
+	// The graph updates right after this on the same worker and reads this update's values (RootYawOffset cancels this frame's yaw change)
+	if (ShooterAnimInstance)
+	{
+		ShooterAnimInstance->CopyProperties(Properties);
+	}
+}
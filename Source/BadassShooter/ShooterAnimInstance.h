@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
 #include "WeaponType.h"
 #include "ShooterAnimInstance.generated.h"
 
@@ -21,24 +22,121 @@ enum class EOffsetState : uint8
 	EOS_MAX			UMETA(DisplayName = "DefaultMAX")
 };
 
+/* Everything the animation update needs from the character, copied on the game thread before the update */
+struct FShooterAnimSnapshot
+{
+	bool bHasCharacter{ false };
+
+	FVector Velocity{ FVector::ZeroVector };
+	FVector Acceleration{ FVector::ZeroVector };
+	FRotator AimRotation{ FRotator::ZeroRotator };
+	FRotator ActorRotation{ FRotator::ZeroRotator };
+
+	/* Combat state flags */
+	bool bIsReloading{ false };
+	bool bIsEquipping{ false };
+	bool bShouldUseFABRIK{ false };
+
+	bool bIsInAir{ false };
+	bool bIsAiming{ false };
+	bool bIsCrouching{ false };
+	bool bIsInCombatPose{ false };
+
+	bool bHasWeapon{ false };
+	EWeaponType WeaponType{ EWeaponType::EWT_AssaultRifle };
+};
+
+/* Everything the animation update computes, worked out on an animation worker thread and copied to the anim instance after the update */
+struct FShooterAnimProperties
+{
+	/* Updates every value from the snapshot and this frame's Turning and Rotation curve values */
+	void Update(const FShooterAnimSnapshot& Snapshot, float TurningCurveValue, float RotationCurveValue, float DeltaTime);
+
+	float CharacterSpeed{ 0.f };
+	bool bIsInAir{ false };
+	bool bIsMoving{ false };
+	bool bIsAiming{ false };
+	bool bIsInCombatPose{ false };
+	bool bIsCrouching{ false };
+	bool bIsReloading{ false };
+	bool bIsEquipping{ false };
+	bool bShouldUseFABRIK{ false };
+
+	float MovementOffsetYaw{ 0.f };
+	float MovementOffsetYawLastFrame{ 0.f };
+
+	EOffsetState OffsetState{ EOffsetState::EOS_NonCombat };
+	EWeaponType EquippedWeaponType{ EWeaponType::EWT_AssaultRifle };
+
+	/* Turn in place and aim offset */
+	float TIPCharacterYaw{ 0.f };
+	float TIPCharacterYawLastFrame{ 0.f };
+	float RootYawOffset{ 0.f };
+	float RotationCurve{ 0.f };
+	float RotationCurveLastFrame{ 0.f };
+	float AimingPitch{ 0.f };
+	bool bIsTurning{ false };
+	float RecoilWeight{ 0.f };
+
+	/* Lean */
+	FRotator CharacterLean{ FRotator::ZeroRotator };
+	FRotator CharacterLeanLastFrame{ FRotator::ZeroRotator };
+	float LeanYawDelta{ 0.f };
+
+private:
+	void TurnInPlace(const FShooterAnimSnapshot& Snapshot, float TurningCurveValue, float RotationCurveValue);
+	void Lean(const FShooterAnimSnapshot& Snapshot, float DeltaTime);
+};
+
+/*
+* Takes the snapshot on the game thread (PreUpdate), works out the properties on an animation worker thread and writes them to the
+* anim instance right before the graph updates on the same worker (Update), so the graph reads this update's values
+* Nothing on the game thread touches the properties while the update is in flight
+*/
+USTRUCT()
+struct BADASSSHOOTER_API FShooterAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FShooterAnimInstanceProxy() = default;
+	FShooterAnimInstanceProxy(UAnimInstance* InAnimInstance) : FAnimInstanceProxy(InAnimInstance) {}
+
+protected:
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+
+private:
+	class UShooterAnimInstance* ShooterAnimInstance{ nullptr };
+	FShooterAnimSnapshot Snapshot;
+	FShooterAnimProperties Properties;
+};
+
 UCLASS()
 class BADASSSHOOTER_API UShooterAnimInstance : public UAnimInstance
 {
 	GENERATED_BODY()
 
+	friend struct FShooterAnimInstanceProxy;
+
 public:
 	UShooterAnimInstance();
 
 	/* Begin Play of AnimInstance class */
 	virtual void NativeInitializeAnimation() override;
 
-	/* Tick of the AnimInstance Class */
-	UFUNCTION(BlueprintCallable)
+	/* Does nothing, the properties are updated natively (see FShooterAnimInstanceProxy). Kept until the animation blueprints stop calling it */
+	UFUNCTION(BlueprintCallable, meta = (DeprecatedFunction, DeprecationMessage = "The properties are updated natively, remove this call"))
 	void UpdateAnimationProperties(float DeltaTime);
 
 protected:
-	void TurnInPlace();
-	void Lean(float DeltaTime);
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+	/* Game thread: copies the character state the update needs */
+	void TakeSnapshot(FShooterAnimSnapshot& OutSnapshot);
+
+	/* Worker thread: copies the properties the proxy worked out, before the anim graph reads them */
+	void CopyProperties(const FShooterAnimProperties& Properties);
 
 private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
@@ -80,10 +178,6 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Movement, meta = (AllowPrivateAccess = "true"))
 	float MovementOffsetYawLastFrame;
 
-	/* Character Yaws used for Turn In Place Animations */
-	float TIPCharacterYaw;
-	float TIPCharacterYawLastFrame;
-
 	/* 
 	* This is the negative of the delta between the CharacterYaw and CharacterYawLastFrame to reorient the root bone when rotating the camera 
 	* so that the character does not move with the camera until the turn in place animation plays 
@@ -91,10 +185,6 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Turn In Place", meta = (AllowPrivateAccess = "true"))
 	float RootYawOffset;
 
-	/* Rotation curve values for turn in place */
-	float RotationCurve;
-	float RotationCurveLastFrame;
-
 	/* Aiming Pitch for aim offset */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Turn In Place", meta = (AllowPrivateAccess = "true"))
 	float AimingPitch;
@@ -104,10 +194,6 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Turn In Place", meta = (AllowPrivateAccess = "true"))
 	EOffsetState OffsetState;
 
-	/* Character Yaws used for Lean Animations */
-	FRotator CharacterLean;
-	FRotator CharacterLeanLastFrame;
-
 	/* Delta for Leaning Animations */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Lean, meta = (AllowPrivateAccess = "true"))
 	float LeanYawDelta;
@@ -116,9 +202,6 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
 	float RecoilWeight;
 
-	/* Boolean to determine if the character is turning */
-	bool bIsTurning;
-
 	/* Weapon type of the Currently equipped weapon */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
 	EWeaponType EquippedWeaponType;
@@ -16,6 +16,10 @@
 #include "Ammo.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "BadassShooter.h"
+#include "ProjectileSubsystem.h"
+#include "HitscanKernel.h"
+#include "TraceBudget.h"
+#include "FixedStepClock.h"
 
 // Sets default values
 AShooterCharacter::AShooterCharacter() :
@@ -27,6 +31,16 @@ AShooterCharacter::AShooterCharacter() :
 	// Look Around Rates Mouse
 	MouseHipLookAroundRate(1.f),
 	MouseAimingLookAroundRate(0.2f),
+	// Impact particles
+	ImpactEffectMergeDistance(20.f),
+	// Penetration
+	MaxPenetrationsPerShot(3),
+	MaxPenetratingShotsPerFrame(8),
+	PenetratingShotsThisFrame(0),
+	PenetrationBudgetFrame(0),
+	// Pellets
+	MaxPelletOverlapRadius(1500.f),
+	MaxPelletBlockers(8),
 	// True when Aiming
 	bIsAiming(false),
 	// Camera FOV
@@ -35,7 +49,8 @@ AShooterCharacter::AShooterCharacter() :
 	CameraCurrentFOV(0.f),
 	CameraZoomInterpSpeed(40.f),
 	// Crosshair Spread Factors
-	CrosshairSpreadMultiplier(0.f),
+	CrosshairSpreadMultiplier(0.5f),	// Spread with every factor at rest (CrosshairSpread idles until something changes)
+	PreviousCrosshairSpreadMultiplier(0.5f),
 	CrosshairVelocityFactor(0.f),
 	CrosshairInAirFactor(0.f),
 	CrosshairAimingFactor(0.f),
@@ -43,14 +58,18 @@ AShooterCharacter::AShooterCharacter() :
 	// CrosshairFiringFactor Factors
 	ShootTimeDuration(0.05f),
 	bFiringBullet(false),
+	CrosshairShootTimeLeft(0.f),
 	// Automatic Fire Variables
 	CombatState(ECombatState::ECS_Unoccupied),
 	bFireButtonPressed(false),
+	FireCooldown(0.f),
 	bIsInCombatPose(true),
 	bAimingButtonPressed(false),
 	// Item trace variables
 	bShouldTraceForItems(false),
 	OverlappedItemCount(0),
+	bUseAsyncItemTrace(true),
+	CrosshairTraceLength(50'000.f),
 	// Item Interpolation Variables
 	CameraInterpDistance(250.f),
 	CameraInterpElevation(65.f),
@@ -127,6 +146,13 @@ AShooterCharacter::AShooterCharacter() :
 	InterpComp_6 = CreateDefaultSubobject<USceneComponent>(TEXT("InterpComp_6"));
 	InterpComp_6->SetupAttachment(GetCamera());
 
+	// Default penetration depths for the physical surfaces in DefaultEngine.ini
+	SurfacePenetrationDepth.Add(EPS_Metal, 5.f);
+	SurfacePenetrationDepth.Add(EPS_Stone, 10.f);
+	SurfacePenetrationDepth.Add(EPS_Tile, 15.f);
+	SurfacePenetrationDepth.Add(EPS_Grass, 200.f);
+	SurfacePenetrationDepth.Add(EPS_Water, 100.f);
+
 }
 
 // Called when the game starts or when spawned
@@ -145,6 +171,9 @@ void AShooterCharacter::BeginPlay()
 		CameraCurrentFOV = CameraDefaultFOV;
 	}
 
+	// The anim instance snapshots state that Tick sets (aiming, crouching, combat state), so animate after Tick
+	GetMesh()->AddTickPrerequisiteActor(this);
+
 	// Spawn and attach the default weapon to the character mesh
 	EquipWeapon(SpawnDefaultWeapon());
 	Inventory.Add(EquippedWeapon);
@@ -159,6 +188,9 @@ void AShooterCharacter::BeginPlay()
 	// Set Character Speed
 	GetCharacterMovement()->MaxWalkSpeed = NonCombatSpeed;
 
+	// Look rates only change with the aim state after this
+	SetLookRates();
+
 	// Setup the interp location for weapon and item pickups
 	InitializeInterpLocations();
 
@@ -170,8 +202,7 @@ void AShooterCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 	SetCameraFOV(DeltaTime);
-	SetLookRates();
-	CrosshairSpread(DeltaTime);
+	StepCombat();
 	TraceForItems();
 	InterpCapsuleHalfHeight(DeltaTime);
 
@@ -221,13 +252,15 @@ void AShooterCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputCo
 
 void AShooterCharacter::SetCameraFOV(float DeltaTime)
 {
-	if (bIsAiming)
-	{
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraZoomedFOV, DeltaTime, CameraZoomInterpSpeed);
-	}
-	else
+	// Idle once the FOV reached the target for the current aim state
+	const float TargetFOV{ bIsAiming ? CameraZoomedFOV : CameraDefaultFOV };
+	if (CameraCurrentFOV == TargetFOV) return;
+
+	INC_DWORD_STAT(STAT_CameraFOVUpdates);
+	CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, TargetFOV, DeltaTime, CameraZoomInterpSpeed);
+	if (FMath::IsNearlyEqual(CameraCurrentFOV, TargetFOV, ConvergedTolerance))
 	{
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraDefaultFOV, DeltaTime, CameraZoomInterpSpeed);
+		CameraCurrentFOV = TargetFOV;
 	}
 
 	GetCamera()->SetFieldOfView(CameraCurrentFOV);
@@ -236,6 +269,7 @@ void AShooterCharacter::SetCameraFOV(float DeltaTime)
 
 void AShooterCharacter::SetLookRates()
 {
+	INC_DWORD_STAT(STAT_LookRateUpdates);
 	if (bIsAiming)
 	{
 		LookAroundRate = AimingLookAroundRate;
@@ -322,57 +356,71 @@ void AShooterCharacter::LookUp(float Value)
 
 float AShooterCharacter::GetCrosshairSpreadMultiplier() const
 {
-	return CrosshairSpreadMultiplier;
+	// The spread moves in combat steps, interpolate so the crosshairs stay smooth at any frame rate
+	const FFixedStepClock& CombatClock = GetWorld()->GetSubsystem<UCombatClockSubsystem>()->GetClock();
+	return FMath::Lerp(PreviousCrosshairSpreadMultiplier, CrosshairSpreadMultiplier, CombatClock.GetAlpha());
 }
 
 
 
 void AShooterCharacter::CrosshairSpread(float DeltaTime)
 {
-	// Calculate the Crosshair Velocity Factor by mapping walkspeed to normalized range
+	// Calculate the Crosshair Velocity Factor by mapping walkspeed to normalized range (snapped to buckets so small speed changes do not count as a change)
 	FVector2D WalkSpeedRange{ 0.f, 600.f };
 	FVector2D VelocityFactorRange{ 0.f, 1.f };
 	FVector Velocity{ GetVelocity() };
 	Velocity.Z = 0.f;
-	CrosshairVelocityFactor = FMath::GetMappedRangeValueClamped(WalkSpeedRange, VelocityFactorRange, Velocity.Size());
+	const float VelocityFactor{ FMath::GridSnap(FMath::GetMappedRangeValueClamped(WalkSpeedRange, VelocityFactorRange, Velocity.Size()), CrosshairVelocityBucketSize) };
+
+	const bool bIsFalling{ GetCharacterMovement()->IsFalling() };
+	const float InAirTarget{ bIsFalling ? 2.25f : 0.f };
+	const float AimingTarget{ bIsAiming ? 0.6f : 0.f };
+	const float FiringTarget{ bFiringBullet ? 0.3f : 0.f };
+
+	// Idle while velocity bucket, air, aim and fire state are unchanged and every factor reached its target
+	const bool bConverged{
+		CrosshairVelocityFactor == VelocityFactor &&
+		CrosshairInAirFactor == InAirTarget &&
+		CrosshairAimingFactor == AimingTarget &&
+		CrosshairFiringFactor == FiringTarget };
+	if (bConverged) return;
+
+	INC_DWORD_STAT(STAT_CrosshairSpreadUpdates);
+	CrosshairVelocityFactor = VelocityFactor;
 
 	// Calculate CrosshairInAir Factor by interpolation when in the air
-	if (GetCharacterMovement()->IsFalling())
-	{
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 2.25f, DeltaTime, 2.25f);
-	}
-	else
-	{
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 0.f, DeltaTime, 30.f);
-	}
+	CrosshairInAirFactor = InterpToConverged(CrosshairInAirFactor, InAirTarget, DeltaTime, bIsFalling ? 2.25f : 30.f);
 
 	// Calculate CrosshairAimFactor by Interpolation when aiming
-	if (bIsAiming)
-	{
-		CrosshairAimingFactor = FMath::FInterpTo(CrosshairAimingFactor, 0.6f, DeltaTime, 30.f);
-	}
-	else
-	{
-		CrosshairAimingFactor = FMath::FInterpTo(CrosshairAimingFactor, 0.f, DeltaTime, 30.f);
-	}
+	CrosshairAimingFactor = InterpToConverged(CrosshairAimingFactor, AimingTarget, DeltaTime, 30.f);
 
 	// Calculate CrosshairFiringFactor by interpolation based on if firing
-	if (bFiringBullet)
-	{
-		CrosshairFiringFactor = FMath::FInterpTo(CrosshairFiringFactor, 0.3f, DeltaTime, 60.f);
-	}
-	else
-	{
-		CrosshairFiringFactor = FMath::FInterpTo(CrosshairFiringFactor, 0.f, DeltaTime, 60.f);
-	}
+	CrosshairFiringFactor = InterpToConverged(CrosshairFiringFactor, FiringTarget, DeltaTime, 60.f);
 
 	CrosshairSpreadMultiplier = 0.5f + CrosshairVelocityFactor + CrosshairInAirFactor - CrosshairAimingFactor + CrosshairFiringFactor;
 }
 
+float AShooterCharacter::InterpToConverged(float Current, float Target, float DeltaTime, float InterpSpeed)
+{
+	const float Value{ FMath::FInterpTo(Current, Target, DeltaTime, InterpSpeed) };
+	return FMath::IsNearlyEqual(Value, Target, ConvergedTolerance) ? Target : Value;
+}
+
 void AShooterCharacter::StartCrosshairShootTimer()
 {
 	bFiringBullet = true;
-	GetWorldTimerManager().SetTimer(CrosshairShootTimer, this, &AShooterCharacter::EndCrosshairShootTimer, ShootTimeDuration);
+	CrosshairShootTimeLeft = ShootTimeDuration;
+}
+
+void AShooterCharacter::UpdateCrosshairShootTimer(float StepTime)
+{
+	if (!bFiringBullet) return;
+
+	CrosshairShootTimeLeft -= StepTime;
+	if (CrosshairShootTimeLeft <= 0.f)
+	{
+		EndCrosshairShootTimer();
+	}
 }
 
 void AShooterCharacter::EndCrosshairShootTimer()
@@ -400,11 +448,13 @@ void AShooterCharacter::AimingButtonReleased()
 void AShooterCharacter::Aim()
 {
 	bIsAiming = true;
+	SetLookRates();
 }
 
 void AShooterCharacter::StopAiming()
 {
 	bIsAiming = false;
+	SetLookRates();
 }
 
 
@@ -419,26 +469,56 @@ void AShooterCharacter::FireButtonReleased()
 	bFireButtonPressed = false;
 }
 
-void AShooterCharacter::StartAutoFireTimer()
+void AShooterCharacter::StepCombat()
 {
-	CombatState = ECombatState::ECS_FireTImerInProgress;
-	GetWorldTimerManager().SetTimer(FireTimer, this, &AShooterCharacter::AutoFireTimerReset, EquippedWeapon->GetAutomaticFireRate());
+	const FFixedStepClock& CombatClock = GetWorld()->GetSubsystem<UCombatClockSubsystem>()->GetClock();
+	const int32 NumSteps{ CombatClock.GetNumSteps() };
+	const float StepTime{ CombatClock.GetStepTime() };
+	for (int32 Step = 0; Step < NumSteps; Step++)
+	{
+		PreviousCrosshairSpreadMultiplier = CrosshairSpreadMultiplier;
+		UpdateCrosshairShootTimer(StepTime);
+		CrosshairSpread(StepTime);
+		UpdateFireCadence(StepTime);
+	}
 }
 
-void AShooterCharacter::AutoFireTimerReset()
+void AShooterCharacter::UpdateFireCadence(float StepTime)
 {
-	CombatState = ECombatState::ECS_Unoccupied;
-	if (EquippedWeapon == nullptr) return;
-	if (WeaponHasAmmo())
+	if (CombatState != ECombatState::ECS_FireTImerInProgress) return;
+
+	FireCooldown -= StepTime;
+
+	// Count every shot that became due this step
+	int32 ShotsDue{ 0 };
+	if (EquippedWeapon)
 	{
-		if (bFireButtonPressed && EquippedWeapon->GetIsAutomatic())
+		const FWeaponStatBlock& WeaponStats = EquippedWeapon->GetStats();
+		const float FireInterval{ FMath::Max(WeaponStats.FireInterval, KINDA_SMALL_NUMBER) };
+		while (FireCooldown <= 0.f)
 		{
-			FireWeapon();
+			const bool bCanFireAgain{ bFireButtonPressed && bIsInCombatPose && WeaponStats.bIsAutomatic && EquippedWeapon->GetAmmoInMagazine() > ShotsDue };
+			if (!bCanFireAgain) break;
+
+			++ShotsDue;
+			FireCooldown += FireInterval;
 		}
 	}
-	else
+
+	if (ShotsDue > 0)
 	{
-		ReloadWeapon();
+		FireShots(ShotsDue);
+	}
+
+	// Cooldown ran out without another shot (fire button released, semi automatic weapon or out of ammo)
+	if (FireCooldown <= 0.f)
+	{
+		FireCooldown = 0.f;
+		CombatState = ECombatState::ECS_Unoccupied;
+		if (EquippedWeapon && !WeaponHasAmmo())
+		{
+			ReloadWeapon();
+		}
 	}
 }
 
@@ -450,22 +530,35 @@ void AShooterCharacter::FireWeapon()
 
 	if (WeaponHasAmmo() && (bIsInCombatPose))
 	{
-		PlayFireSound();
-		SendBullet();
-		PlayGunFireMontage();
+		FireShots(1);
+
+		// Start the cooldown. Following shots are fired by UpdateFireCadence
+		CombatState = ECombatState::ECS_FireTImerInProgress;
+		FireCooldown = EquippedWeapon->GetStats().FireInterval;
+	}
+}
+
+void AShooterCharacter::FireShots(int32 ShotCount)
+{
+	PlayFireSound();
+	SendBullet(ShotCount);
+	PlayGunFireMontage();
+	for (int32 i = 0; i < ShotCount; i++)
+	{
 		EquippedWeapon->DecrementAmmo();
-		StartCrosshairShootTimer();
-		StartAutoFireTimer();
+	}
+	StartCrosshairShootTimer();
 
-		if (EquippedWeapon->GetWeaponType() == EWeaponType::EWT_Pistol)
-		{
-			EquippedWeapon->StartPistolSlideTimer();
-		}
+	if (EquippedWeapon->GetStats().WeaponType == EWeaponType::EWT_Pistol)
+	{
+		EquippedWeapon->StartPistolSlideTimer();
 	}
 }
 
 bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation)
 {
+		SCOPE_CYCLE_COUNTER(STAT_GetBeamEndLocation);
+
 		// Check for crosshair trace hit
 		FHitResult CrosshairHitResult;
 		bool bCrosshairHit = TraceUnderCrosshairs(CrosshairHitResult, OutBeamLocation);
@@ -486,7 +579,12 @@ bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation,
 		const FVector StartToEnd{ OutBeamLocation - WeaponTraceStart };
 		const FVector WeaponTraceEnd{ MuzzleSocketLocation + StartToEnd * 1.25f };	// End of Line Trace (which is the end of the previous line trace)
 
-		GetWorld()->LineTraceSingleByChannel(WeaponTraceHitResult, WeaponTraceStart, WeaponTraceEnd, ECollisionChannel::ECC_Visibility);
+		// Pawns block weapon fire so our own capsule has to be ignored
+		FCollisionQueryParams WeaponTraceParams(SCENE_QUERY_STAT(WeaponTrace), false, this);
+		WeaponTraceParams.AddIgnoredActor(EquippedWeapon);
+		INC_DWORD_STAT(STAT_BeamQueries);
+		FTraceBudget::AddCombatQueries(GetWorld());
+		GetWorld()->LineTraceSingleByChannel(WeaponTraceHitResult, WeaponTraceStart, WeaponTraceEnd, ECC_WeaponFire, WeaponTraceParams);
 		if (WeaponTraceHitResult.bBlockingHit)
 		{
 			OutBeamLocation = WeaponTraceHitResult.Location;
@@ -498,6 +596,23 @@ bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation,
 
 bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation)
 {
+	const FCrosshairTrace& Trace = GetCrosshairTrace();
+	if (Trace.bHasRay)
+	{
+		OutHitResult = Trace.HitResult;
+		OutHitLocation = Trace.HitLocation;
+	}
+	return Trace.bHit;
+}
+
+const FCrosshairTrace& AShooterCharacter::GetCrosshairRay()
+{
+	// Already deprojected this frame
+	if (CrosshairTrace.RayFrame == GFrameCounter) return CrosshairTrace;
+
+	CrosshairTrace.RayFrame = GFrameCounter;
+	CrosshairTrace.bHasRay = false;
+
 	// Get Viewport Size
 	FVector2D ViewportSize;
 	if (GEngine && GEngine->GameViewport)
@@ -507,108 +622,217 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 
 	// Get screen space location of crosshairs
 	FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
-	FVector CrosshairWorldPosition;
-	FVector CrosshairWorldDirection;
 
 	// Get world position and direction of crosshairs
-	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(
+	CrosshairTrace.bHasRay = UGameplayStatics::DeprojectScreenToWorld(
 		UGameplayStatics::GetPlayerController(this, 0),
 		CrosshairLocation,
-		CrosshairWorldPosition,
-		CrosshairWorldDirection);
+		CrosshairTrace.Origin,
+		CrosshairTrace.Direction);
+
+	return CrosshairTrace;
+}
+
+const FCrosshairTrace& AShooterCharacter::GetCrosshairTrace()
+{
+	// Already traced this frame
+	if (CrosshairTrace.TraceFrame == GFrameCounter) return CrosshairTrace;
+
+	GetCrosshairRay();
+	CrosshairTrace.TraceFrame = GFrameCounter;
+	CrosshairTrace.HitResult = FHitResult();
+	CrosshairTrace.bHit = false;
 
-	if (bScreenToWorld)
+	if (CrosshairTrace.bHasRay)
 	{
 		// Trace from Crosshair world location outward
-		const FVector Start{ CrosshairWorldPosition };
-		const FVector End{ Start + CrosshairWorldDirection * 50'000.f };
-		OutHitLocation = End;
-		GetWorld()->LineTraceSingleByChannel(OutHitResult, Start, End, ECollisionChannel::ECC_Visibility);
-		if (OutHitResult.bBlockingHit)
+		const FVector Start{ CrosshairTrace.Origin };
+		const FVector End{ Start + CrosshairTrace.Direction * CrosshairTraceLength };
+		CrosshairTrace.HitLocation = End;
+		SCOPE_CYCLE_COUNTER(STAT_TraceUnderCrosshairs);
+		INC_DWORD_STAT(STAT_CrosshairQueries);
+		FTraceBudget::AddCombatQueries(GetWorld());
+
+		const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CrosshairTrace), false, this);
+		GetWorld()->LineTraceSingleByChannel(CrosshairTrace.HitResult, Start, End, ECC_WeaponFire, QueryParams);
+		if (CrosshairTrace.HitResult.bBlockingHit)
 		{
-			OutHitLocation = OutHitResult.Location;
-			return true;
+			CrosshairTrace.HitLocation = CrosshairTrace.HitResult.Location;
+			CrosshairTrace.bHit = true;
 		}
 	}
-	return false;
+	return CrosshairTrace;
 }
 
 void AShooterCharacter::TraceForItems()
 {
+	SCOPE_CYCLE_COUNTER(STAT_TraceForItems);
+
 	if (bShouldTraceForItems)
 	{
-		FHitResult ItemTraceResult;
-		FVector HitLocation;
-		TraceUnderCrosshairs(ItemTraceResult, HitLocation);
-		if (ItemTraceResult.bBlockingHit)
+		INC_DWORD_STAT(STAT_ItemTraceUpdates);
+		if (bUseAsyncItemTrace)
 		{
-			TraceHitItem = Cast<AItem>(ItemTraceResult.Actor);
-			const auto TraceHitWeapon = Cast<AWeapon>(TraceHitItem);
+			AsyncTraceForItems();
+			return;
+		}
 
-			// This is to prevent spamming of the TraceHitItem if it is already interping 
-			if (TraceHitItem && TraceHitItem->GetItemState() == EItemState::EIS_EquipInterping)
+		// Item focus only considers pickup boxes (the shared crosshair trace is for weapon fire)
+		// Item focus is low priority, when the frame is out of trace budget the current focus is kept until next frame
+		const FCrosshairTrace& Ray = GetCrosshairRay();
+		if (Ray.bHasRay && TryItemFocusQuery())
+		{
+			FHitResult ItemTraceResult;
+			const FVector Start{ Ray.Origin };
+			const FVector End{ Start + Ray.Direction * CrosshairTraceLength };
+			if (GetWorld()->LineTraceSingleByObjectType(ItemTraceResult, Start, End, FCollisionObjectQueryParams(ECC_Pickup)))
 			{
-				TraceHitItem = nullptr;
-			}
-
-			// Check if the traced item is a weapon and play the highlight animation
-			if (TraceHitWeapon)
-			{
-				// If there are no slots being highlighted then highlight the slot
-				if (HighlightedSlot == -1)
-				{
-					HighlightWeaponSlot();
-				}
+				UpdateTraceHitItem(ItemTraceResult);
 			}
 			else
 			{
-				// No weapon being traced and if a highlight is playing then turn it off
-				if (HighlightedSlot != -1)
-				{
-					UnHighlightWeaponSlot();
-				}
+				ClearTraceHitItem();
 			}
+		}
+	}
+	else
+	{
+		// Drop any trace that is still in flight so it is not applied when we start tracing again
+		ItemTraceHandle = FTraceHandle();
 
-			if (TraceHitItem && TraceHitItem->GetPickupWidget())
-			{
-				// Show Item's Pickup Widget
-				TraceHitItem->GetPickupWidget()->SetVisibility(true);
-				TraceHitItem->EnableCustomDepth();
+		if (TraceHitItemLastFrame)
+		{
+			// No longer overlapping any items,
+			// Item last frame should not show widget
+			TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
+			TraceHitItemLastFrame->DisableCustomDepth();
 
-				// When tracing for items we want to determine if the inventory is full and if it is display pickup or swap on the widget
-				// It makes sense to do it here since this is where we set the visibility for the pickup widget
+			// Hidden once, nothing to do on the following frames until we overlap an item again
+			TraceHitItemLastFrame = nullptr;
+		}
+	}
+}
 
-				if (Inventory.Num() >= INVENTORY_CAPACITY)
-				{
-					TraceHitItem->SetInventoryIsFull(true);
-				}
-				else
-				{
-					TraceHitItem->SetInventoryIsFull(false);
-				}
-			}
+void AShooterCharacter::AsyncTraceForItems()
+{
+	UWorld* World = GetWorld();
 
-			// We hit an AItem last frame
-			if (TraceHitItemLastFrame)
-			{
-				if (TraceHitItem != TraceHitItemLastFrame)
-				{
-					// We are hitting a different AItem this frame from last frame
-					// Or AItem is null.
-					TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
-					TraceHitItemLastFrame->DisableCustomDepth();
-				}
-			}
-			// Store a reference to HitItem for next frame
-			TraceHitItemLastFrame = TraceHitItem;
+	// Apply the result of the trace we requested last frame
+	FTraceDatum ItemTraceDatum;
+	if (ItemTraceHandle.IsValid() && World->QueryTraceData(ItemTraceHandle, ItemTraceDatum))
+	{
+		const FHitResult* ItemTraceResult = FHitResult::GetFirstBlockingHit(ItemTraceDatum.OutHits);
+		if (ItemTraceResult)
+		{
+			UpdateTraceHitItem(*ItemTraceResult);
+		}
+		else
+		{
+			ClearTraceHitItem();
+		}
+	}
+
+	// Request this frame's trace (result is ready next frame)
+	ItemTraceHandle = FTraceHandle();
+	const FCrosshairTrace& Ray = GetCrosshairRay();
+	if (Ray.bHasRay && TryItemFocusQuery())
+	{
+		const FVector Start{ Ray.Origin };
+		const FVector End{ Start + Ray.Direction * CrosshairTraceLength };
+		ItemTraceHandle = World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Start, End, FCollisionObjectQueryParams(ECC_Pickup));
+	}
+}
+
+bool AShooterCharacter::TryItemFocusQuery()
+{
+	if (!FTraceBudget::TryLowPriorityQuery(GetWorld()))
+	{
+		INC_DWORD_STAT(STAT_DeferredQueries);
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_ItemFocusQueries);
+	return true;
+}
+
+void AShooterCharacter::UpdateTraceHitItem(const FHitResult& ItemTraceResult)
+{
+	TraceHitItem = Cast<AItem>(ItemTraceResult.Actor);
+	const auto TraceHitWeapon = Cast<AWeapon>(TraceHitItem);
+
+	// This is to prevent spamming of the TraceHitItem if it is already interping 
+	if (TraceHitItem && TraceHitItem->GetItemState() == EItemState::EIS_EquipInterping)
+	{
+		TraceHitItem = nullptr;
+	}
+
+	// Check if the traced item is a weapon and play the highlight animation
+	if (TraceHitWeapon)
+	{
+		// If there are no slots being highlighted then highlight the slot
+		if (HighlightedSlot == -1)
+		{
+			HighlightWeaponSlot();
 		}
 	}
-	else if (TraceHitItemLastFrame)
+	else
+	{
+		// No weapon being traced and if a highlight is playing then turn it off
+		if (HighlightedSlot != -1)
+		{
+			UnHighlightWeaponSlot();
+		}
+	}
+
+	if (TraceHitItem && TraceHitItem->GetPickupWidget())
+	{
+		// Show Item's Pickup Widget
+		TraceHitItem->GetPickupWidget()->SetVisibility(true);
+		TraceHitItem->EnableCustomDepth();
+
+		// When tracing for items we want to determine if the inventory is full and if it is display pickup or swap on the widget
+		// It makes sense to do it here since this is where we set the visibility for the pickup widget
+
+		if (Inventory.Num() >= INVENTORY_CAPACITY)
+		{
+			TraceHitItem->SetInventoryIsFull(true);
+		}
+		else
+		{
+			TraceHitItem->SetInventoryIsFull(false);
+		}
+	}
+
+	// We hit an AItem last frame
+	if (TraceHitItemLastFrame)
+	{
+		if (TraceHitItem != TraceHitItemLastFrame)
+		{
+			// We are hitting a different AItem this frame from last frame
+			// Or AItem is null.
+			TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
+			TraceHitItemLastFrame->DisableCustomDepth();
+		}
+	}
+	// Store a reference to HitItem for next frame
+	TraceHitItemLastFrame = TraceHitItem;
+}
+
+void AShooterCharacter::ClearTraceHitItem()
+{
+	// Looking away from every pickup, nothing can be picked up until the next hit
+	TraceHitItem = nullptr;
+
+	if (HighlightedSlot != -1)
+	{
+		UnHighlightWeaponSlot();
+	}
+
+	if (TraceHitItemLastFrame)
 	{
-		// No longer overlapping any items,
-		// Item last frame should not show widget
 		TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
 		TraceHitItemLastFrame->DisableCustomDepth();
+		TraceHitItemLastFrame = nullptr;
 	}
 }
 
@@ -635,9 +859,11 @@ void AShooterCharacter::PlayFireSound()
 	}
 }
 
-void AShooterCharacter::SendBullet()
+void AShooterCharacter::SendBullet(int32 ShotCount)
 {
-	// Send Bullet
+	if (ShotCount <= 0) return;
+
+	// Shots fired in the same frame leave from the same muzzle transform, every shot is still resolved as its own ray
 	const USkeletalMeshSocket* BarrelSocket_1 = EquippedWeapon->GetItemMesh()->GetSocketByName(TEXT("MuzzleFlashSocket"));
 
 	if (BarrelSocket_1)
@@ -648,17 +874,280 @@ void AShooterCharacter::SendBullet()
 			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), EquippedWeapon->GetMuzzleFlash(), BarrelSocketTransform_1);
 		}
 
-		FVector BeamEnd_1;
-		FVector BeamEnd_2;
-		bool bBeamEndLocation_1 = GetBeamEndLocation(BarrelSocketTransform_1.GetLocation(), BeamEnd_1);
+		TArray<FVector> ImpactLocations;
+		const int32 PelletCount{ EquippedWeapon->GetPelletCount() };
+		if (EquippedWeapon->GetFiresProjectiles())
+		{
+			// Projectile weapon: bullets are handed to the projectile pool, impacts are spawned when they land
+			FireProjectiles(BarrelSocketTransform_1.GetLocation(), PelletCount * ShotCount);
+		}
+		else if (PelletCount > 1)
+		{
+			// Spread weapon: every pellet of every shot due this frame is resolved in one batch
+			GetPelletEndLocations(BarrelSocketTransform_1.GetLocation(), PelletCount * ShotCount, EquippedWeapon->GetPelletSpreadAngle(), ImpactLocations);
+		}
+		else
+		{
+			// Penetrating shots are resolved one by one while the frame's penetration budget lasts
+			int32 ShotsLeft{ ShotCount };
+			while (ShotsLeft > 0 && EquippedWeapon->GetCanPenetrate() && ConsumePenetrationBudget())
+			{
+				GetPenetratingBeamImpacts(BarrelSocketTransform_1.GetLocation(), ImpactLocations);
+				--ShotsLeft;
+			}
+
+			if (ShotsLeft > 1)
+			{
+				// Several shots due this frame: one ray per shot, each with its own spread sample, resolved in one batch like pellets
+				GetPelletEndLocations(BarrelSocketTransform_1.GetLocation(), ShotsLeft, EquippedWeapon->GetPelletSpreadAngle(), ImpactLocations);
+			}
+			else if (ShotsLeft == 1)
+			{
+				FVector BeamEnd_1;
+				bool bBeamEndLocation_1 = GetBeamEndLocation(BarrelSocketTransform_1.GetLocation(), BeamEnd_1);
+
+				if (bBeamEndLocation_1)
+				{
+					ImpactLocations.Add(BeamEnd_1);
+				}
+			}
+		}
+
+		SpawnImpactEffects(ImpactLocations);
+	}
+}
+
+void AShooterCharacter::FireProjectiles(const FVector& MuzzleSocketLocation, int32 NumProjectiles)
+{
+	UProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+	const FCrosshairTrace& Trace = GetCrosshairTrace();
+	if (ProjectileSubsystem == nullptr || !Trace.bHasRay) return;
+
+	// Aim from the muzzle at whatever is under the crosshairs, pellets spread around that direction like hitscan pellets
+	const FVector AimDirection{ (Trace.HitLocation - MuzzleSocketLocation).GetSafeNormal() };
+	const float SpreadHalfAngle{ FMath::DegreesToRadians(FMath::Max(EquippedWeapon->GetPelletSpreadAngle(), 0.f)) };
+
+	for (int32 i = 0; i < NumProjectiles; i++)
+	{
+		const FVector Direction{ SpreadHalfAngle > 0.f ? FMath::VRandCone(AimDirection, SpreadHalfAngle) : AimDirection };
+		ProjectileSubsystem->FireProjectile(
+			MuzzleSocketLocation,
+			Direction * EquippedWeapon->GetProjectileSpeed(),
+			EquippedWeapon->GetProjectileGravityScale(),
+			EquippedWeapon->GetProjectileLifetime(),
+			this,
+			BulletImpactParticles);
+	}
+}
+
+void AShooterCharacter::GetPelletEndLocations(const FVector& MuzzleSocketLocation, int32 NumPellets, float SpreadAngle, TArray<FVector>& OutImpactLocations)
+{
+	// One crosshair trace (shared with the rest of the frame) gives the aim point for all pellets
+	const FCrosshairTrace& Trace = GetCrosshairTrace();
+	if (!Trace.bHasRay) return;
+
+	const FVector MuzzleToAim{ Trace.HitLocation - MuzzleSocketLocation };
+	const FVector AimDirection{ MuzzleToAim.GetSafeNormal() };
+	const float TraceLength{ MuzzleToAim.Size() * 1.25f };
+	const float SpreadHalfAngle{ FMath::DegreesToRadians(FMath::Clamp(SpreadAngle, 0.f, 80.f)) };
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(PelletTrace), false, this);
+	QueryParams.AddIgnoredActor(EquippedWeapon);
+
+	UWorld* World = GetWorld();
+	TArray<FHitscanRay, TInlineAllocator<16>> PelletRays;
+	PelletRays.Reserve(NumPellets);
+	for (int32 i = 0; i < NumPellets; i++)
+	{
+		PelletRays.Add({ MuzzleSocketLocation, FMath::VRandCone(AimDirection, SpreadHalfAngle), TraceLength });
+	}
+
+	// Test all pellets against the pawn hitboxes at once
+	FCapsuleHitboxes PawnHitboxes;
+	TArray<FHitscanCandidate> PawnCandidates;
+	FHitscanKernel::GatherPawnHitboxes(World, this, PawnHitboxes);
+	FHitscanKernel::IntersectRays(PelletRays, PawnHitboxes, PawnCandidates);
+
+	// Pawns are left to their hitboxes, so their collision is not a candidate (each pawn is ignored once, not once per capsule)
+	TArray<const AActor*, TInlineAllocator<16>> HitboxOwners;
+	for (int32 CapsuleIndex = 0; CapsuleIndex < PawnHitboxes.Num(); CapsuleIndex++)
+	{
+		HitboxOwners.AddUnique(PawnHitboxes.Owners[CapsuleIndex]);
+	}
+	for (const AActor* HitboxOwner : HitboxOwners)
+	{
+		QueryParams.AddIgnoredActor(HitboxOwner);
+	}
+
+	// One broad query for the rest of the scene: every component blocking weapon fire inside a capsule around the spread cone
+	// The cone ends just past the crosshair hit, shots into open space or very wide cones would overlap most of the level
+	const float ConeRadius{ FMath::Max(TraceLength * FMath::Tan(SpreadHalfAngle), 1.f) };
+	bool bTracePellets{ !Trace.bHit || ConeRadius > MaxPelletOverlapRadius };
+
+	TArray<UPrimitiveComponent*, TInlineAllocator<16>> Blockers;
+	if (!bTracePellets)
+	{
+		const FCollisionShape ConeBounds{ FCollisionShape::MakeCapsule(ConeRadius, TraceLength * 0.5f + ConeRadius) };
+		TArray<FOverlapResult> Overlaps;
+		FTraceBudget::AddCombatQueries(World);
+		World->OverlapMultiByChannel(Overlaps, MuzzleSocketLocation + AimDirection * (TraceLength * 0.5f), FRotationMatrix::MakeFromZ(AimDirection).ToQuat(), ECC_WeaponFire, ConeBounds, QueryParams);
+
+		for (const FOverlapResult& Overlap : Overlaps)
+		{
+			UPrimitiveComponent* Component = Overlap.GetComponent();
+			if (Overlap.bBlockingHit && Component)
+			{
+				Blockers.AddUnique(Component);
+			}
+		}
+
+		// Testing every pellet against every blocker only pays off for a handful of blockers
+		bTracePellets = Blockers.Num() > MaxPelletBlockers;
+	}
+	if (bTracePellets)
+	{
+		FTraceBudget::AddCombatQueries(World, NumPellets);
+	}
+
+	// The closest of scene and hitbox hit wins
+	OutImpactLocations.Reserve(OutImpactLocations.Num() + NumPellets);
+	for (int32 i = 0; i < NumPellets; i++)
+	{
+		const FHitscanRay& PelletRay = PelletRays[i];
+		const FVector PelletEnd{ PelletRay.Origin + PelletRay.Direction * PelletRay.Length };
 
-		if (bBeamEndLocation_1)
+		float ClosestDistance{ PawnCandidates[i].CapsuleIndex != INDEX_NONE ? PawnCandidates[i].Distance : TNumericLimits<float>::Max() };
+		if (bTracePellets)
 		{
-			if (BulletImpactParticles)
+			FHitResult PelletHitResult;
+			if (World->LineTraceSingleByChannel(PelletHitResult, PelletRay.Origin, PelletEnd, ECC_WeaponFire, QueryParams))
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BulletImpactParticles, BeamEnd_1);
+				ClosestDistance = FMath::Min(ClosestDistance, PelletHitResult.Time * PelletRay.Length);
+			}
+		}
+		else
+		{
+			for (UPrimitiveComponent* Blocker : Blockers)
+			{
+				FHitResult PelletHitResult;
+				if (Blocker->LineTraceComponent(PelletHitResult, PelletRay.Origin, PelletEnd, QueryParams))
+				{
+					ClosestDistance = FMath::Min(ClosestDistance, PelletHitResult.Time * PelletRay.Length);
+				}
 			}
 		}
+
+		if (ClosestDistance < TNumericLimits<float>::Max())
+		{
+			OutImpactLocations.Add(PelletRay.Origin + PelletRay.Direction * ClosestDistance);
+		}
+	}
+}
+
+void AShooterCharacter::GetPenetratingBeamImpacts(const FVector& MuzzleSocketLocation, TArray<FVector>& OutImpactLocations)
+{
+	const FCrosshairTrace& Trace = GetCrosshairTrace();
+	if (!Trace.bHasRay) return;
+
+	const FVector Start{ MuzzleSocketLocation };
+	const FVector End{ MuzzleSocketLocation + (Trace.HitLocation - MuzzleSocketLocation) * 1.25f };
+	const float TraceLength{ FVector::Dist(Start, End) };
+
+	// Object queries return every hit along the line instead of stopping at the first blocking hit
+	FCollisionObjectQueryParams ObjectQueryParams;
+	ObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldStatic);
+	ObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_WorldDynamic);
+	ObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_PhysicsBody);
+	ObjectQueryParams.AddObjectTypesToQuery(ECollisionChannel::ECC_Pawn);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(PenetrationTrace), false, this);
+	QueryParams.AddIgnoredActor(EquippedWeapon);
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	// Entry points
+	TArray<FHitResult> EntryHits;
+	FTraceBudget::AddCombatQueries(GetWorld(), 2);
+	GetWorld()->LineTraceMultiByObjectType(EntryHits, Start, End, ObjectQueryParams, QueryParams);
+
+	// Only surfaces that would block a regular shot count (skips item area spheres and the like)
+	EntryHits.RemoveAll([](const FHitResult& Hit)
+	{
+		return !Hit.Component.IsValid() || Hit.Component->GetCollisionResponseToChannel(ECC_WeaponFire) != ECollisionResponse::ECR_Block;
+	});
+	if (EntryHits.Num() == 0) return;
+
+	// Exit points are the entry points of the same line traced backwards
+	TArray<FHitResult> ExitHits;
+	QueryParams.bReturnPhysicalMaterial = false;
+	GetWorld()->LineTraceMultiByObjectType(ExitHits, End, Start, ObjectQueryParams, QueryParams);
+
+	int32 Penetrations{ 0 };
+	for (const FHitResult& EntryHit : EntryHits)
+	{
+		OutImpactLocations.Add(EntryHit.Location);
+
+		// Find where the bullet leaves this component (closest exit beyond the entry)
+		const float EntryDistance{ EntryHit.Distance };
+		float ExitDistance{ TNumericLimits<float>::Max() };
+		FVector ExitLocation{ EntryHit.Location };
+		for (const FHitResult& ExitHit : ExitHits)
+		{
+			const float DistanceFromStart{ TraceLength - ExitHit.Distance };
+			if (ExitHit.Component == EntryHit.Component && DistanceFromStart > EntryDistance && DistanceFromStart < ExitDistance)
+			{
+				ExitDistance = DistanceFromStart;
+				ExitLocation = ExitHit.Location;
+			}
+		}
+
+		// Compare the surface thickness with how deep the bullet can go into this surface type
+		const EPhysicalSurface SurfaceType{ UPhysicalMaterial::DetermineSurfaceType(EntryHit.PhysMaterial.Get()) };
+		const float* MaxDepth = SurfacePenetrationDepth.Find(SurfaceType);
+		const bool bPenetrates{ MaxDepth && ExitDistance - EntryDistance <= *MaxDepth };
+		if (!bPenetrates || ++Penetrations > MaxPenetrationsPerShot) return;
+
+		OutImpactLocations.Add(ExitLocation);
+	}
+}
+
+bool AShooterCharacter::ConsumePenetrationBudget()
+{
+	if (PenetrationBudgetFrame != GFrameCounter)
+	{
+		PenetrationBudgetFrame = GFrameCounter;
+		PenetratingShotsThisFrame = 0;
+	}
+
+	if (PenetratingShotsThisFrame >= MaxPenetratingShotsPerFrame) return false;
+
+	++PenetratingShotsThisFrame;
+	return true;
+}
+
+void AShooterCharacter::SpawnImpactEffects(const TArray<FVector>& ImpactLocations)
+{
+	if (BulletImpactParticles == nullptr || ImpactLocations.Num() == 0) return;
+
+	// Merge impacts that are close together so a tight pellet group does not spawn one emitter per pellet
+	const float MergeDistanceSquared{ FMath::Square(ImpactEffectMergeDistance) };
+	TArray<FVector, TInlineAllocator<16>> EffectLocations;
+	for (const FVector& ImpactLocation : ImpactLocations)
+	{
+		const bool bMerged = EffectLocations.ContainsByPredicate([&](const FVector& EffectLocation)
+		{
+			return FVector::DistSquared(EffectLocation, ImpactLocation) <= MergeDistanceSquared;
+		});
+
+		if (!bMerged)
+		{
+			EffectLocations.Add(ImpactLocation);
+		}
+	}
+
+	// Pooled particle components so rapid fire does not allocate a new component for every impact
+	for (const FVector& EffectLocation : EffectLocations)
+	{
+		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BulletImpactParticles, EffectLocation, FRotator::ZeroRotator, FVector(1.f), true, EPSCPoolMethod::AutoRelease);
 	}
 }
 
@@ -725,6 +1214,16 @@ void AShooterCharacter::EquipWeapon(AWeapon* WeaponToEquip, bool bSwapping)
 			EquipItemDelegate.Broadcast(EquippedWeapon->GetSlotIndex(), WeaponToEquip->GetSlotIndex());
 		}
 
+		// The held weapon mesh animates after the character mesh and after UWeaponMotionSubsystem has moved the pistol slide (TG_PostPhysics)
+		// so it reads this frame's pose and state, weapons that are not held animate in the default tick group
+		if (EquippedWeapon)
+		{
+			EquippedWeapon->GetItemMesh()->RemoveTickPrerequisiteComponent(GetMesh());
+			EquippedWeapon->GetItemMesh()->SetTickGroup(TG_PrePhysics);
+		}
+		WeaponToEquip->GetItemMesh()->AddTickPrerequisiteComponent(GetMesh());
+		WeaponToEquip->GetItemMesh()->SetTickGroup(TG_PostUpdateWork);
+
 		EquippedWeapon = WeaponToEquip;
 		EquippedWeapon->SetItemState(EItemState::EIS_Equipped);
 	}
@@ -736,6 +1235,8 @@ void AShooterCharacter::DropWeapon()
 	{
 		FDetachmentTransformRules DetachmentRules(EDetachmentRule::KeepWorld, true);
 		EquippedWeapon->GetItemMesh()->DetachFromComponent(DetachmentRules);
+		EquippedWeapon->GetItemMesh()->RemoveTickPrerequisiteComponent(GetMesh());
+		EquippedWeapon->GetItemMesh()->SetTickGroup(TG_PrePhysics);
 		EquippedWeapon->SetItemState(EItemState::EIS_Falling);
 		EquippedWeapon->ThrowWeapon();
 	}
@@ -872,12 +1373,13 @@ void AShooterCharacter::FinishReloading()
 	}
 
 	// Update the ammo map with the reloaded ammo
-	const auto AmmoType = EquippedWeapon->GetAmmoType();
+	const FWeaponStatBlock& WeaponStats = EquippedWeapon->GetStats();
+	const auto AmmoType = WeaponStats.AmmoType;
 
 	if (AmmoMap.Contains(AmmoType))
 	{
 		int32 CarriedAmmo = AmmoMap[AmmoType];
-		const int32 MagazineEmptySpace = EquippedWeapon->GetMaximumMagazineCapacity() - EquippedWeapon->GetAmmoInMagazine();
+		const int32 MagazineEmptySpace = WeaponStats.MagazineCapacity - EquippedWeapon->GetAmmoInMagazine();
 		if (MagazineEmptySpace > CarriedAmmo)
 		{
 			CarriedAmmo = 0;
@@ -899,7 +1401,7 @@ bool AShooterCharacter::CarryingAmmo()
 {
 	if (EquippedWeapon == nullptr) return false;
 
-	auto AmmoType = EquippedWeapon->GetAmmoType();
+	auto AmmoType = EquippedWeapon->GetStats().AmmoType;
 	if (AmmoMap.Contains(AmmoType))
 	{
 		return AmmoMap[AmmoType] > 0;
@@ -993,7 +1495,11 @@ void AShooterCharacter::InterpCapsuleHalfHeight(float DeltaTime)
 		TargetCapsuleHalfHeight = StandingCapsuleHalfHeight;
 	}
 
-	const float InterpHalfHeight{ FMath::FInterpTo(GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), TargetCapsuleHalfHeight, DeltaTime, 15.f ) };
+	// SetCapsuleHalfHeight updates overlaps so it is only called until the capsule reaches the height for the crouch state
+	if (GetCapsuleComponent()->GetScaledCapsuleHalfHeight() == TargetCapsuleHalfHeight) return;
+
+	INC_DWORD_STAT(STAT_CapsuleHeightUpdates);
+	const float InterpHalfHeight{ InterpToConverged(GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), TargetCapsuleHalfHeight, DeltaTime, 15.f ) };
 
 	// The mesh will dip into the floor when crouching so we need to set an offset so we can move the character out of the floor
 	// Negative when crouching, Positive when standing 
@@ -1185,14 +1691,6 @@ void AShooterCharacter::UnHighlightWeaponSlot()
 
 EPhysicalSurface AShooterCharacter::GetFoostepsSurface()
 {
-	FHitResult HitResult;
-	const FVector Start{ GetActorLocation() };
-	const FVector End{ Start + FVector(0.f, 0.f, -400.f) };
-	FCollisionQueryParams QueryParams;
-	QueryParams.bReturnPhysicalMaterial = true;
-
-	GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Visibility, QueryParams);
-
-	return UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+	return FootstepSurfaceCache.GetSurface(this);
 }
 
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "AmmoType.h"
+#include "FootstepSurfaceCache.h"
 #include "ShooterCharacter.generated.h"
 
 
@@ -36,6 +37,33 @@ struct FInterpLocation
 		
 };
 
+/*
+* Ray through the center of the crosshairs and its first blocking hit.
+* Computed at most once per frame and shared by everything that needs what is under the crosshairs (item tracing, beam end location etc.)
+*/
+struct FCrosshairTrace
+{
+	/* World position and direction of the crosshairs */
+	FVector Origin{ FVector::ZeroVector };
+	FVector Direction{ FVector::ForwardVector };
+
+	/* First blocking hit along the ray */
+	FHitResult HitResult;
+
+	/* Location of the blocking hit, or the end of the trace if nothing was hit */
+	FVector HitLocation{ FVector::ZeroVector };
+
+	/* True when the crosshairs could be deprojected into the world this frame */
+	bool bHasRay{ false };
+
+	/* True when the trace hit something this frame */
+	bool bHit{ false };
+
+	/* Frame numbers (GFrameCounter) the ray and the trace were computed on */
+	uint64 RayFrame{ MAX_uint64 };
+	uint64 TraceFrame{ MAX_uint64 };
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FEquipItemDelegate, int32, CurrentSlotIndex, int32, NewSlotIndex);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FHighlightIconDelegate, int32, SlotIndex, bool, bPlayIconAnimation);
 
@@ -68,6 +96,24 @@ protected:
 	bool TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation);
 	void TraceForItems();
 
+	/* Updates the focused item (pickup widget, custom depth and weapon slot highlight) from an item trace hit */
+	void UpdateTraceHitItem(const FHitResult& ItemTraceResult);
+
+	/* Drops the focused item after an item trace that hit nothing (hides its widget and outline, stops the weapon slot highlight) */
+	void ClearTraceHitItem();
+
+	/* Item focus traces are low priority, returns false when this frame's trace budget is used up (focus is kept until next frame) */
+	bool TryItemFocusQuery();
+
+	/* Issues this frame's async item trace and consumes the result of last frame's trace */
+	void AsyncTraceForItems();
+
+	/* Returns the crosshair ray for this frame (deprojects the crosshairs only on the first call of the frame) */
+	const FCrosshairTrace& GetCrosshairRay();
+
+	/* Returns the crosshair ray and its hit for this frame (traces only on the first call of the frame) */
+	const FCrosshairTrace& GetCrosshairTrace();
+
 	/* Functions for aiming the weapon */
 	void AimingButtonPressed();
 	void AimingButtonReleased();
@@ -90,17 +136,26 @@ protected:
 	/* Function to calculate the crosshair spread */
 	void CrosshairSpread(float DeltaTime);
 
-	/* Functions for the CrosshairShootTimer Handle*/
+	/* FInterpTo that snaps to the target once it is within ConvergedTolerance (so the per frame updates can go idle) */
+	static float InterpToConverged(float Current, float Target, float DeltaTime, float InterpSpeed);
+
+	/* Functions for the crosshair shoot timer (counted down in combat steps) */
 	void StartCrosshairShootTimer();
-	UFUNCTION()
-	void EndCrosshairShootTimer(); // Callback for StartCrosshairShootTimer()
+	void UpdateCrosshairShootTimer(float StepTime);
+	void EndCrosshairShootTimer();
+
+	/* Runs the fixed step combat simulation (crosshair shoot timer, crosshair spread and fire cadence) for the steps the world's combat clock has due this frame */
+	void StepCombat();
 
 	/* Functions for Automatic Fire */
 	void FireButtonPressed();
 	void FireButtonReleased();
-	void StartAutoFireTimer();
-	UFUNCTION()
-	void AutoFireTimerReset(); // Callback for StartAutoFireTimer()
+
+	/* 
+	* Advances the fire cooldown and fires every shot that is due this step
+	* @param StepTime: Time to advance the cooldown by. Leftover time carries into the next shot so the rate of fire does not depend on frame rate
+	*/
+	void UpdateFireCadence(float StepTime);
 
 
 	/* Functions for Interacting (pickup/select) Items/Actors in game */
@@ -128,9 +183,36 @@ protected:
 
 	/* Fire Weapon Functions */
 	void PlayFireSound();
-	void SendBullet();
+	void SendBullet(int32 ShotCount = 1);
 	void PlayGunFireMontage();
 
+	/* Fires ShotCount shots that are due in the same frame (one sound, one montage and one bullet resolve for all of them) */
+	void FireShots(int32 ShotCount);
+
+	/* Hands NumProjectiles bullets to the world's projectile pool (weapons that fire projectiles instead of hitscan) */
+	void FireProjectiles(const FVector& MuzzleSocketLocation, int32 NumProjectiles);
+
+	/* 
+	* Resolves the end locations of every pellet of a spread shot (or every shot of a burst due in one frame) in one pass
+	* Pellets share the crosshair trace and are tested against pawn hitboxes in one batch (FHitscanKernel)
+	* The rest of the scene is one overlap query around the spread cone (ending just past the crosshair hit), pellets are then traced against those components only
+	* Shots into open space, very wide cones or cones full of blockers trace each pellet against the scene instead
+	*/
+	void GetPelletEndLocations(const FVector& MuzzleSocketLocation, int32 NumPellets, float SpreadAngle, TArray<FVector>& OutImpactLocations);
+
+	/*
+	* Resolves a beam that can pass through thin surfaces
+	* Entry and exit points come from one forward and one reverse multi trace and the thickness of each surface is compared against SurfacePenetrationDepth
+	* Appends the entry and exit impacts to OutImpactLocations
+	*/
+	void GetPenetratingBeamImpacts(const FVector& MuzzleSocketLocation, TArray<FVector>& OutImpactLocations);
+
+	/* Returns false when this frame's penetration budget (MaxPenetratingShotsPerFrame) is used up */
+	bool ConsumePenetrationBudget();
+
+	/* Spawns the impact particles for a batch of impacts, merging impacts that land close together */
+	void SpawnImpactEffects(const TArray<FVector>& ImpactLocations);
+
 	/* Reloading Functions */
 	UFUNCTION(BlueprintCallable) // Called from blueprint (reload montage anim notify)
 	void FinishReloading();
@@ -182,7 +264,7 @@ protected:
 	/* Functions that use the highlight delegate to highlight and unlights the weapon slot */
 	void HighlightWeaponSlot();
 
-	/* Does a line trace to get the surface the character is walking on */
+	/* Returns the surface the character is walking on (only traces when the floor changes) */
 	UFUNCTION(BlueprintCallable)
 	EPhysicalSurface GetFoostepsSurface();
 	
@@ -240,6 +322,34 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
 	UParticleSystem* BulletImpactParticles;
 
+	/* Impacts closer together than this spawn a single impact particle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	float ImpactEffectMergeDistance;
+
+	/* Maximum thickness (cm) of each surface type a penetrating bullet can pass through. Surfaces not in the map stop the bullet */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	TMap<TEnumAsByte<EPhysicalSurface>, float> SurfacePenetrationDepth;
+
+	/* Maximum number of surfaces a single bullet can pass through */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	int32 MaxPenetrationsPerShot;
+
+	/* Maximum number of penetrating shots resolved per frame (the rest are resolved as regular shots) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	int32 MaxPenetratingShotsPerFrame;
+
+	/* Number of penetrating shots resolved on PenetrationBudgetFrame */
+	int32 PenetratingShotsThisFrame;
+	uint64 PenetrationBudgetFrame;
+
+	/* Spread cones wider than this (at the crosshair hit) trace each pellet instead of one overlap query around the cone */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	float MaxPelletOverlapRadius;
+
+	/* Overlap queries returning more blocking components than this trace each pellet instead of testing every pellet against every component */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	int32 MaxPelletBlockers;
+
 	/* Boolean to be set when aiming button is pressed or released */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	bool bIsAiming;
@@ -269,6 +379,9 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Crosshair, meta = (AllowPrivateAccess = "true"))
 	float CrosshairSpreadMultiplier;
 
+	/* CrosshairSpreadMultiplier before the last combat step (the HUD interpolates between the two) */
+	float PreviousCrosshairSpreadMultiplier;
+
 	/* Amount we spread crosshairs by depending on movement speed */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Crosshair, meta = (AllowPrivateAccess = "true"))
 	float CrosshairVelocityFactor;
@@ -285,10 +398,16 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Crosshair, meta = (AllowPrivateAccess = "true"))
 	float CrosshairFiringFactor;
 
+	/* Velocity factor is snapped to steps of this size so only a change of speed bucket updates the spread */
+	static constexpr float CrosshairVelocityBucketSize{ 1.f / 32.f };
+
+	/* Interpolated values snap to their target once they are this close */
+	static constexpr float ConvergedTolerance{ 0.01f };
+
 	/* Variables to calculate the CrosshairFiringFactor*/
 	float ShootTimeDuration;
 	bool bFiringBullet;
-	FTimerHandle CrosshairShootTimer;
+	float CrosshairShootTimeLeft;
 
 	/*--------------------------------- WEAPON FIRE, RELOADING, EQUIPPING --------------------------------------------------------*/
 
@@ -299,7 +418,8 @@ private:
 	/* Boolean for if the player is pressing the fire button */
 	bool bFireButtonPressed;
 
-	FTimerHandle FireTimer;
+	/* Time left until the weapon can fire again (negative values are time owed to the next shot) */
+	float FireCooldown;
 
 	/* Reloading Animation (section depends on the weapon type) */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta = (AllowPrivateAccess = "true"))
@@ -338,6 +458,20 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
 	AItem* TraceHitItem;
 
+	/* When true TraceForItems uses an async trace and applies its result one frame later */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Items, meta = (AllowPrivateAccess = "true"))
+	bool bUseAsyncItemTrace;
+
+	/* Handle of the async item trace requested last frame */
+	FTraceHandle ItemTraceHandle;
+
+	/* Per frame cache of the crosshair ray and trace */
+	FCrosshairTrace CrosshairTrace;
+
+	/* Length of the trace from the crosshairs */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta = (AllowPrivateAccess = "true"))
+	float CrosshairTraceLength;
+
 	/*------------------- INTERPOLATION FOR ITEMS (THE WAY THEY MOVE UP AND DOWN WHEN EQUIPPING) -----------------------------------*/
 
 	/* Distance forward from the camera (front of the camera where items will travel to) */
@@ -462,6 +596,11 @@ private:
 	/* Slot that is currently being highlighted in the inventory */
 	int32 HighlightedSlot;
 
+	/*------------------------------------------------------------ Footsteps -----------------------------------------------------------------*/
+
+	/* Surface under the character, keyed on the character movement floor */
+	FFootstepSurfaceCache FootstepSurfaceCache;
+
 public:
 	FORCEINLINE USpringArmComponent* GetCameraSpringArm() const { return CameraSpringArm; }
 	FORCEINLINE UCameraComponent* GetCamera() const { return Camera; }
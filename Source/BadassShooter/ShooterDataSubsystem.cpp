@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterDataSubsystem.h"
+#include "Engine/DataTable.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "Item.h"
+#include "Weapon.h"
+
+namespace
+{
+	/* Row names in the tables, in enum order */
+	const TCHAR* const RarityRowNames[] = { TEXT("Lame"), TEXT("Okay"), TEXT("Cool"), TEXT("Crazy"), TEXT("Badass") };
+	const TCHAR* const WeaponRowNames[] = { TEXT("AR15"), TEXT("AssaultRifle"), TEXT("Pistol") };
+
+	static_assert(UE_ARRAY_COUNT(RarityRowNames) == static_cast<int32>(EItemRarity::EIR_MAX), "RarityRowNames has to match EItemRarity");
+	static_assert(UE_ARRAY_COUNT(WeaponRowNames) == static_cast<int32>(EWeaponType::EWT_MAX), "WeaponRowNames has to match EWeaponType");
+
+	constexpr int32 NumWeaponTypes{ static_cast<int32>(EWeaponType::EWT_MAX) };
+
+	/* Loads a table and checks it has the expected row struct */
+	UDataTable* LoadTable(const FSoftObjectPath& Path, const UScriptStruct* RowStruct)
+	{
+		UDataTable* Table = Cast<UDataTable>(Path.TryLoad());
+		if (Table == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShooterDataSubsystem: could not load %s"), *Path.ToString());
+			return nullptr;
+		}
+		if (Table->GetRowStruct() != RowStruct)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShooterDataSubsystem: %s does not use %s rows"), *Path.ToString(), *RowStruct->GetName());
+			return nullptr;
+		}
+		return Table;
+	}
+
+	/* Fills Rows in enum order, warning about every missing row */
+	template<typename RowType, int32 NumRows>
+	void IndexRows(UDataTable* Table, const TCHAR* const (&RowNames)[NumRows], TArray<RowType*>& Rows)
+	{
+		Rows.Init(nullptr, NumRows);
+		if (Table == nullptr) return;
+
+		for (int32 Index = 0; Index < NumRows; Index++)
+		{
+			Rows[Index] = Table->FindRow<RowType>(FName(RowNames[Index]), TEXT(""), false);
+			if (Rows[Index] == nullptr)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("ShooterDataSubsystem: %s has no row %s"), *Table->GetName(), RowNames[Index]);
+			}
+		}
+	}
+}
+
+UShooterDataSubsystem::UShooterDataSubsystem() :
+	ItemRarityDataTablePath(TEXT("/Game/_Game/DataTables/ItemRarityDataTable.ItemRarityDataTable")),
+	WeaponDataTablePath(TEXT("/Game/_Game/DataTables/WeaponDataTable.WeaponDataTable")),
+	FallbackWeaponProxyMeshPath(TEXT("/Engine/BasicShapes/Cube.Cube")),
+	ItemRarityDataTable(nullptr),
+	WeaponDataTable(nullptr)
+{
+	for (int32 Index = 0; Index < NumWeaponTypes; Index++)
+	{
+		WeaponStats[Index] = FWeaponStatBlock::GetDefault(static_cast<EWeaponType>(Index));
+	}
+}
+
+void UShooterDataSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LoadTables();
+}
+
+UShooterDataSubsystem* UShooterDataSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	if (GameInstance)
+	{
+		return GameInstance->GetSubsystem<UShooterDataSubsystem>();
+	}
+
+	// No game instance (construction scripts in the editor, commandlets): one shared instance loaded on first use
+	static UShooterDataSubsystem* FallbackSubsystem = nullptr;
+	if (FallbackSubsystem == nullptr)
+	{
+		FallbackSubsystem = NewObject<UShooterDataSubsystem>(GetTransientPackage());
+		FallbackSubsystem->AddToRoot();
+		FallbackSubsystem->LoadTables();
+	}
+	return FallbackSubsystem;
+}
+
+const FItemRarityTable* UShooterDataSubsystem::GetRarityRow(EItemRarity Rarity) const
+{
+	const int32 Index{ static_cast<int32>(Rarity) };
+	return RarityRows.IsValidIndex(Index) ? RarityRows[Index] : nullptr;
+}
+
+const FWeaponDataTable* UShooterDataSubsystem::GetWeaponRow(EWeaponType WeaponType) const
+{
+	const int32 Index{ static_cast<int32>(WeaponType) };
+	return WeaponRows.IsValidIndex(Index) ? WeaponRows[Index] : nullptr;
+}
+
+const FWeaponStatBlock& UShooterDataSubsystem::GetWeaponStats(EWeaponType WeaponType) const
+{
+	const int32 Index{ static_cast<int32>(WeaponType) };
+	return Index < NumWeaponTypes ? WeaponStats[Index] : FWeaponStatBlock::GetDefault(WeaponType);
+}
+
+void UShooterDataSubsystem::RequestWeaponAssets(EWeaponType WeaponType, FSimpleDelegate OnLoaded)
+{
+	const int32 Index{ static_cast<int32>(WeaponType) };
+	TArray<FSoftObjectPath> AssetPaths;
+	if (!WeaponAssetRequests.IsValidIndex(Index) || !GetWeaponAssetPaths(WeaponType, AssetPaths))
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	FWeaponAssetRequest& Request = WeaponAssetRequests[Index];
+	++Request.NumHolders;
+	if (!Request.Handle.IsValid())
+	{
+		Request.Handle = StreamableManager.RequestAsyncLoad(AssetPaths, FStreamableDelegate::CreateUObject(this, &UShooterDataSubsystem::OnWeaponAssetsLoaded, WeaponType));
+	}
+
+	// No handle means there was nothing to load
+	if (!Request.Handle.IsValid() || Request.Handle->HasLoadCompleted())
+	{
+		OnLoaded.ExecuteIfBound();
+	}
+	else
+	{
+		Request.OnLoaded.Add(OnLoaded);
+	}
+}
+
+void UShooterDataSubsystem::ReleaseWeaponAssets(EWeaponType WeaponType, const UObject* Holder)
+{
+	const int32 Index{ static_cast<int32>(WeaponType) };
+	if (!WeaponAssetRequests.IsValidIndex(Index)) return;
+
+	// Other holders can keep the load going, the released holder must not be called back once it finishes
+	FWeaponAssetRequest& Request = WeaponAssetRequests[Index];
+	Request.OnLoaded.RemoveAll([Holder](const FSimpleDelegate& Callback) { return Callback.IsBoundToObject(Holder); });
+
+	Request.NumHolders = FMath::Max(Request.NumHolders - 1, 0);
+	if (Request.NumHolders > 0) return;
+
+	// Last holder gone, the assets are unloaded by the next garbage collection unless something else references them
+	if (Request.Handle.IsValid())
+	{
+		if (Request.Handle->HasLoadCompleted())
+		{
+			Request.Handle->ReleaseHandle();
+		}
+		else
+		{
+			Request.Handle->CancelHandle();
+		}
+		Request.Handle.Reset();
+	}
+	Request.OnLoaded.Reset();
+}
+
+bool UShooterDataSubsystem::AreWeaponAssetsLoaded(EWeaponType WeaponType) const
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	if (!GetWeaponAssetPaths(WeaponType, AssetPaths)) return false;
+
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (AssetPath.ResolveObject() == nullptr) return false;
+	}
+	return true;
+}
+
+FSoftObjectPath UShooterDataSubsystem::GetWeaponProxyMeshPath(EWeaponType WeaponType) const
+{
+	const FWeaponDataTable* WeaponRow = GetWeaponRow(WeaponType);
+	if (WeaponRow == nullptr) return FSoftObjectPath();
+
+	// The shipped table has no proxy meshes (and no static weapon meshes to fill it with) yet, a stand in keeps far pickups stowable
+	return WeaponRow->PickupProxyMesh.IsNull() ? FallbackWeaponProxyMeshPath : WeaponRow->PickupProxyMesh.ToSoftObjectPath();
+}
+
+bool UShooterDataSubsystem::GetWeaponAssetPaths(EWeaponType WeaponType, TArray<FSoftObjectPath>& OutPaths) const
+{
+	const FWeaponDataTable* WeaponRow = GetWeaponRow(WeaponType);
+	if (WeaponRow == nullptr) return false;
+
+	WeaponRow->GetAssetPaths(OutPaths);
+	const FSoftObjectPath ProxyMeshPath{ GetWeaponProxyMeshPath(WeaponType) };
+	if (ProxyMeshPath.IsValid())
+	{
+		OutPaths.AddUnique(ProxyMeshPath);
+	}
+	return true;
+}
+
+void UShooterDataSubsystem::OnWeaponAssetsLoaded(EWeaponType WeaponType)
+{
+	const int32 Index{ static_cast<int32>(WeaponType) };
+	if (!WeaponAssetRequests.IsValidIndex(Index)) return;
+
+	// Callbacks can request or release assets, so run them from a copy
+	TArray<FSimpleDelegate> OnLoaded{ MoveTemp(WeaponAssetRequests[Index].OnLoaded) };
+	WeaponAssetRequests[Index].OnLoaded.Reset();
+	for (FSimpleDelegate& Callback : OnLoaded)
+	{
+		Callback.ExecuteIfBound();
+	}
+}
+
+void UShooterDataSubsystem::LoadTables()
+{
+	WeaponAssetRequests.SetNum(static_cast<int32>(EWeaponType::EWT_MAX));
+
+	ItemRarityDataTable = LoadTable(ItemRarityDataTablePath, FItemRarityTable::StaticStruct());
+	WeaponDataTable = LoadTable(WeaponDataTablePath, FWeaponDataTable::StaticStruct());
+
+#if WITH_EDITOR
+	// Row pointers are invalidated when a table is edited or reimported
+	if (ItemRarityDataTable)
+	{
+		ItemRarityDataTable->OnDataTableChanged().AddUObject(this, &UShooterDataSubsystem::BuildRowIndices);
+	}
+	if (WeaponDataTable)
+	{
+		WeaponDataTable->OnDataTableChanged().AddUObject(this, &UShooterDataSubsystem::BuildRowIndices);
+	}
+#endif
+
+	BuildRowIndices();
+}
+
+void UShooterDataSubsystem::BuildRowIndices()
+{
+	IndexRows(ItemRarityDataTable, RarityRowNames, RarityRows);
+	IndexRows(WeaponDataTable, WeaponRowNames, WeaponRows);
+
+	for (int32 Index = 0; Index < NumWeaponTypes; Index++)
+	{
+		const EWeaponType WeaponType{ static_cast<EWeaponType>(Index) };
+		const FWeaponStatBlock& DefaultStats{ FWeaponStatBlock::GetDefault(WeaponType) };
+		if (WeaponRows[Index] == nullptr)
+		{
+			WeaponStats[Index] = DefaultStats;
+			continue;
+		}
+
+		WeaponStats[Index] = FWeaponStatBlock::FromRow(WeaponType, *WeaponRows[Index]);
+
+		// The built in stats stand in for the row whenever it is missing, so they should not drift from the table
+		const FWeaponStatBlock& RowStats{ WeaponStats[Index] };
+		if (RowStats.AmmoType != DefaultStats.AmmoType ||
+			!FMath::IsNearlyEqual(RowStats.FireInterval, DefaultStats.FireInterval) ||
+			RowStats.MagazineCapacity != DefaultStats.MagazineCapacity ||
+			RowStats.bIsAutomatic != DefaultStats.bIsAutomatic)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShooterDataSubsystem: row %s of %s does not match the built in stats of its weapon type (see WeaponStatBlock.cpp)"),
+				WeaponRowNames[Index], *WeaponDataTable->GetName());
+		}
+	}
+}
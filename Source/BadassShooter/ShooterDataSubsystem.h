@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Engine/StreamableManager.h"
+#include "WeaponStatBlock.h"
+#include "ShooterDataSubsystem.generated.h"
+
+enum class EItemRarity : uint8;
+
+/**
+ * Loads the item rarity and weapon data tables once, validates them and indexes their rows by EItemRarity / EWeaponType
+ * Items look their rows up here in OnConstruction instead of resolving the table path and hashing a row name per actor
+ * Outside of a game instance (editor construction scripts) a single rooted fallback instance is used
+ *
+ * Weapon assets are soft references that are streamed in per weapon type while at least one weapon holds a request
+ * (owned weapons and pickups in relevance range), so only those weapon types stay resident
+ */
+UCLASS(config = Game)
+class BADASSSHOOTER_API UShooterDataSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UShooterDataSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/* Subsystem of the context's game instance, or the editor fallback when there is none */
+	static UShooterDataSubsystem* Get(const UObject* WorldContextObject);
+
+	/* Row for a rarity/weapon type, nullptr if the table or row is missing */
+	const struct FItemRarityTable* GetRarityRow(EItemRarity Rarity) const;
+	const struct FWeaponDataTable* GetWeaponRow(EWeaponType WeaponType) const;
+
+	/* Combat stats of a weapon type (built from its row, the built in defaults if the row is missing) */
+	const FWeaponStatBlock& GetWeaponStats(EWeaponType WeaponType) const;
+
+	/*
+	* Adds a holder to the weapon type's assets and starts loading them asynchronously if they are not loaded yet
+	* @param OnLoaded: Assets-ready callback, executed right away if the assets are already loaded
+	*/
+	void RequestWeaponAssets(EWeaponType WeaponType, FSimpleDelegate OnLoaded);
+
+	/*
+	* Removes a holder, the assets can be unloaded once the last holder is gone
+	* @param Holder: Object the holder's OnLoaded is bound to, its callback is dropped if the load is still pending
+	*/
+	void ReleaseWeaponAssets(EWeaponType WeaponType, const UObject* Holder);
+
+	/* True if every asset of the weapon type is in memory */
+	bool AreWeaponAssetsLoaded(EWeaponType WeaponType) const;
+
+	/* Proxy mesh of stowed pickups of the weapon type (the row's PickupProxyMesh, FallbackWeaponProxyMeshPath if the row has none) */
+	FSoftObjectPath GetWeaponProxyMeshPath(EWeaponType WeaponType) const;
+
+private:
+	/* Loads the tables and builds the row indices */
+	void LoadTables();
+
+	/* Rebuilds the row indices from the loaded tables (also called when a table is edited in the editor) */
+	void BuildRowIndices();
+
+	/* Every asset streamed in for a weapon type (row assets and proxy mesh), false if the row is missing */
+	bool GetWeaponAssetPaths(EWeaponType WeaponType, TArray<FSoftObjectPath>& OutPaths) const;
+
+	/* Assets-ready callback for a weapon type's load, runs the callbacks of every waiting request */
+	void OnWeaponAssetsLoaded(EWeaponType WeaponType);
+
+	UPROPERTY(Config)
+	FSoftObjectPath ItemRarityDataTablePath;
+
+	UPROPERTY(Config)
+	FSoftObjectPath WeaponDataTablePath;
+
+	/* Drawn for stowed weapon pickups whose row has no PickupProxyMesh, weapons stay actors if this is empty too */
+	UPROPERTY(Config)
+	FSoftObjectPath FallbackWeaponProxyMeshPath;
+
+	UPROPERTY()
+	class UDataTable* ItemRarityDataTable;
+
+	UPROPERTY()
+	UDataTable* WeaponDataTable;
+
+	/* Rows indexed by enum value (pointers into the tables above) */
+	TArray<FItemRarityTable*> RarityRows;
+	TArray<FWeaponDataTable*> WeaponRows;
+
+	/* Stat blocks indexed by weapon type, one cache line each */
+	FWeaponStatBlock WeaponStats[static_cast<uint8>(EWeaponType::EWT_MAX)];
+
+	/* Streaming state of one weapon type's assets */
+	struct FWeaponAssetRequest
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<FSimpleDelegate> OnLoaded;
+		int32 NumHolders{ 0 };
+	};
+
+	/* Indexed by weapon type */
+	TArray<FWeaponAssetRequest> WeaponAssetRequests;
+
+	FStreamableManager StreamableManager;
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterTickSubsystem.h"
+#include "Engine/World.h"
+
+void FShooterSubsystemTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill() && TickType != LEVELTICK_ViewportsOnly)
+	{
+		FScopeCycleCounterUObject SubsystemScope(Target);
+		Target->Tick(DeltaTime);
+	}
+}
+
+FString FShooterSubsystemTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[Tick]") : TEXT("UShooterTickSubsystem[Tick]");
+}
+
+UShooterTickSubsystem::UShooterTickSubsystem()
+{
+	TickFunction.bCanEverTick = true;
+	TickFunction.TickGroup = TG_PostUpdateWork;
+	TickFunction.Target = this;
+
+	// Off until there is something to update
+	TickFunction.SetTickFunctionEnable(false);
+}
+
+void UShooterTickSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Only game worlds get here, so the class default object and editor worlds never register
+	if (!TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.RegisterTickFunction(InWorld.PersistentLevel);
+	}
+}
+
+void UShooterTickSubsystem::Deinitialize()
+{
+	if (TickFunction.IsTickFunctionRegistered())
+	{
+		TickFunction.UnRegisterTickFunction();
+	}
+
+	Super::Deinitialize();
+}
+
+void UShooterTickSubsystem::SetTickEnabled(bool bEnabled)
+{
+	if (TickFunction.IsTickFunctionEnabled() != bEnabled)
+	{
+		TickFunction.SetTickFunctionEnable(bEnabled);
+	}
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterTickSubsystem.generated.h"
+
+/* Tick function that forwards to a UShooterTickSubsystem */
+USTRUCT()
+struct FShooterSubsystemTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/* Subsystem that is ticked */
+	class UShooterTickSubsystem* Target{ nullptr };
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShooterSubsystemTickFunction> : public TStructOpsTypeTraitsBase2<FShooterSubsystemTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * World subsystem that ticks in an explicit tick group (FTickableGameObjects all run at one fixed point of the frame)
+ * Subclasses pick their group in the constructor and switch the tick on only while they have something to update
+ */
+UCLASS(Abstract)
+class BADASSSHOOTER_API UShooterTickSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UShooterTickSubsystem();
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) {}
+
+protected:
+	/* Turns the tick function on or off */
+	void SetTickEnabled(bool bEnabled);
+
+	FShooterSubsystemTickFunction TickFunction;
+};
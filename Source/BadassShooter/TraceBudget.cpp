@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TraceBudget.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "BadassShooter.h"
+
+static int32 GTraceBudget{ 48 };
+static FAutoConsoleVariableRef CVarTraceBudget(
+	TEXT("Shooter.TraceBudget"),
+	GTraceBudget,
+	TEXT("Scene queries per frame after which low priority queries (item focus, footsteps) are deferred or dropped. 0 = no budget"),
+	ECVF_Default);
+
+void FTraceBudget::AddCombatQueries(const UWorld* World, int32 NumQueries)
+{
+	if (UTraceBudgetSubsystem* Budget = World ? World->GetSubsystem<UTraceBudgetSubsystem>() : nullptr)
+	{
+		Budget->AddCombatQueries(NumQueries);
+	}
+}
+
+void FTraceBudget::ReserveCombatQueries(const UWorld* World, int32 NumQueries)
+{
+	if (UTraceBudgetSubsystem* Budget = World ? World->GetSubsystem<UTraceBudgetSubsystem>() : nullptr)
+	{
+		Budget->ReserveCombatQueries(NumQueries);
+	}
+}
+
+bool FTraceBudget::TryLowPriorityQuery(const UWorld* World)
+{
+	UTraceBudgetSubsystem* Budget = World ? World->GetSubsystem<UTraceBudgetSubsystem>() : nullptr;
+	return Budget == nullptr || Budget->TryLowPriorityQuery();
+}
+
+void UTraceBudgetSubsystem::AddCombatQueries(int32 NumQueries)
+{
+	UpdateFrame();
+	QueriesThisFrame += NumQueries;
+}
+
+void UTraceBudgetSubsystem::ReserveCombatQueries(int32 NumQueries)
+{
+	UpdateFrame();
+	ReservedQueries = NumQueries;
+}
+
+bool UTraceBudgetSubsystem::TryLowPriorityQuery()
+{
+	UpdateFrame();
+	if (GTraceBudget > 0 && QueriesThisFrame >= GTraceBudget)
+	{
+		return false;
+	}
+
+	++QueriesThisFrame;
+	return true;
+}
+
+void UTraceBudgetSubsystem::UpdateFrame()
+{
+	// Only game thread code asks for queries so a plain frame counter is enough
+	check(IsInGameThread());
+	if (Frame != GFrameCounter)
+	{
+		Frame = GFrameCounter;
+		QueriesThisFrame = ReservedQueries;
+		ReservedQueries = 0;
+	}
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TraceBudget.generated.h"
+
+/*
+* Per frame budget of gameplay scene queries (Shooter.TraceBudget), kept per world so PIE instances do not share one budget
+* Combat queries (crosshair, beams, pellets, projectiles) always run and are only counted. Low priority queries (item focus,
+* footsteps) have to ask first and are deferred or dropped once the frame has used up its budget, so a firefight cannot also
+* pay for every cosmetic trace on the same frame
+*/
+struct FTraceBudget
+{
+	/* Counts combat queries that were issued this frame */
+	static void AddCombatQueries(const UWorld* World, int32 NumQueries = 1);
+
+	/* Charges combat queries that will run later in the next frame (e.g. projectile sweeps), before any low priority query asks */
+	static void ReserveCombatQueries(const UWorld* World, int32 NumQueries);
+
+	/* Returns true (and counts the query) if a low priority query still fits in this frame's budget */
+	static bool TryLowPriorityQuery(const UWorld* World);
+};
+
+/* Query counters of one world (see FTraceBudget) */
+UCLASS()
+class BADASSSHOOTER_API UTraceBudgetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void AddCombatQueries(int32 NumQueries);
+	void ReserveCombatQueries(int32 NumQueries);
+	bool TryLowPriorityQuery();
+
+private:
+	/* Brings the counter to the current frame, starting from the queries reserved for it */
+	void UpdateFrame();
+
+	uint64 Frame{ 0 };
+	int32 QueriesThisFrame{ 0 };
+	int32 ReservedQueries{ 0 };
+};
@@ -3,8 +3,43 @@
 
 #include "Weapon.h"
 #include "Kismet/GameplayStatics.h"
+#include "WeaponMotionSubsystem.h"
+#include "ShooterDataSubsystem.h"
+#include "PickupStoreSubsystem.h"
+#include "Engine/StaticMesh.h"
 
 
+void FWeaponDataTable::GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const
+{
+	const FSoftObjectPath AssetPaths[] = {
+		PickupSound.ToSoftObjectPath(), EquipSound.ToSoftObjectPath(), WeaponMesh.ToSoftObjectPath(),
+		WeaponInventoryIcon.ToSoftObjectPath(), WeaponAmmoInventoryIcon.ToSoftObjectPath(), MaterialInstance.ToSoftObjectPath(),
+		AnimBP.ToSoftObjectPath(), CrosshairMiddle.ToSoftObjectPath(), CrosshairLeft.ToSoftObjectPath(),
+		CrosshairRight.ToSoftObjectPath(), CrosshairTop.ToSoftObjectPath(), CrosshairBottom.ToSoftObjectPath(),
+		MuzzleFlash.ToSoftObjectPath(), FireSound.ToSoftObjectPath(), PickupProxyMesh.ToSoftObjectPath() };
+
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (AssetPath.IsValid())
+		{
+			OutPaths.AddUnique(AssetPath);
+		}
+	}
+}
+
+FWeaponStatBlock FWeaponStatBlock::FromRow(EWeaponType WeaponType, const FWeaponDataTable& WeaponRow)
+{
+	FWeaponStatBlock Block{ WeaponType, WeaponRow.AmmoType, WeaponRow.AutomaticFireRate, WeaponRow.MagazineCapacity, WeaponRow.bIsAutomatic };
+	Block.PelletCount = FMath::Max(WeaponRow.PelletCount, 1);
+	Block.PelletSpreadAngle = WeaponRow.PelletSpreadAngle;
+	Block.bCanPenetrate = WeaponRow.bCanPenetrate;
+	Block.bFiresProjectiles = WeaponRow.bFiresProjectiles;
+	Block.ProjectileSpeed = WeaponRow.ProjectileSpeed;
+	Block.ProjectileGravityScale = WeaponRow.ProjectileGravityScale;
+	Block.ProjectileLifetime = WeaponRow.ProjectileLifetime;
+	return Block;
+}
+
 AWeapon::AWeapon() :
 	ThrowWeaponTime(1.3f),
 	bIsFalling(false),
@@ -18,19 +53,59 @@ AWeapon::AWeapon() :
 	bIsMagMoving(false),
 	PistolSlideDisplacement(0.f),
 	PistolRecoilRotation(0.f),
+	PistolSlideElapsed(0.f),
+	PreviousPistolSlideCurveValue(0.f),
+	PistolSlideCurveValue(0.f),
 	PistolSlideDuration(0.2f),
 	bPistolSlideMoving(false),
 	MaxPistolSlideDisplacement(4.f),
 	MaxPistolRecoilRotation(20.f),
-	bIsAutomatic(true)
+	bIsAutomatic(true),
+	PelletCount(1),
+	PelletSpreadAngle(0.f),
+	bCanPenetrate(false),
+	bFiresProjectiles(false),
+	ProjectileSpeed(40000.f),
+	ProjectileGravityScale(1.f),
+	ProjectileLifetime(3.f),
+	Stats(&FWeaponStatBlock::GetDefault(EWeaponType::EWT_AssaultRifle)),
+	bHoldsAssetRequest(false),
+	bWeaponAssetsApplied(false)
+{
+#if WITH_EDITORONLY_DATA
+	EditorPreviewMesh = nullptr;
+#endif
+}
+
+void AWeapon::BeginPlay()
 {
-	PrimaryActorTick.bCanEverTick = true;
+	Super::BeginPlay();
+
+	// Placed weapons do not run OnConstruction again when play starts
+	UpdateStats();
 }
 
-void AWeapon::Tick(float DeltaTime)
+void AWeapon::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	Super::EndPlay(EndPlayReason);
+
+	if (UWeaponMotionSubsystem* MotionSubsystem = GetWorld()->GetSubsystem<UWeaponMotionSubsystem>())
+	{
+		MotionSubsystem->RemoveWeapon(this);
+	}
+
+	if (bHoldsAssetRequest)
+	{
+		bHoldsAssetRequest = false;
+		if (UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this))
+		{
+			DataSubsystem->ReleaseWeaponAssets(WeaponType, this);
+		}
+	}
+}
 
+void AWeapon::UpdateMotion(int32 NumSteps, float StepTime, float Alpha)
+{
 	// Keep the Weapon upright
 	if (GetItemState() == EItemState::EIS_Falling && bIsFalling)
 	{
@@ -39,7 +114,23 @@ void AWeapon::Tick(float DeltaTime)
 	}
 
 	// Update Slide Bone on Pistol when firing pistol
-	UpdateSlideDisplacement();
+	UpdateSlideDisplacement(NumSteps, StepTime, Alpha);
+}
+
+void AWeapon::UpdateMotionRegistration()
+{
+	UWorld* World = GetWorld();
+	UWeaponMotionSubsystem* MotionSubsystem = World ? World->GetSubsystem<UWeaponMotionSubsystem>() : nullptr;
+	if (MotionSubsystem == nullptr) return;
+
+	if (bIsFalling || bPistolSlideMoving)
+	{
+		MotionSubsystem->AddWeapon(this);
+	}
+	else
+	{
+		MotionSubsystem->RemoveWeapon(this);
+	}
 }
 
 void AWeapon::ThrowWeapon()
@@ -59,6 +150,7 @@ void AWeapon::ThrowWeapon()
 	GetItemMesh()->AddImpulse(ImpulseDirection);
 
 	bIsFalling = true;
+	UpdateMotionRegistration();
 
 	GetWorldTimerManager().SetTimer(ThrowWeaponTimer, this, &AWeapon::StopFalling, ThrowWeaponTime);
 
@@ -68,83 +160,224 @@ void AWeapon::ThrowWeapon()
 void AWeapon::StopFalling()
 {
 	bIsFalling = false;
+	UpdateMotionRegistration();
 	SetItemState(EItemState::EIS_Pickup);
-	StartPulseTimer();
 }
 
 void AWeapon::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
-	const FString WeaponTablePath(TEXT("DataTable'/Game/_Game/DataTables/WeaponDataTable.WeaponDataTable'"));
-	UDataTable* WeaponTableObject = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, *WeaponTablePath));
+	// Weapon row comes from the data subsystem (loaded once and indexed by weapon type)
+	const UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+	const FWeaponDataTable* WeaponRow = DataSubsystem ? DataSubsystem->GetWeaponRow(WeaponType) : nullptr;
 
-	if (WeaponTableObject)
+	UpdateStats();
+
+	if (WeaponRow)
 	{
-		FWeaponDataTable* WeaponRow = nullptr;
-		switch (WeaponType)
+		AmmoInMagazine = WeaponRow->WeaponAmmo;
+		SetItemTypeString(WeaponRow->WeaponName);
+
+		PreviousMaterialIndex = GetMaterialIndex();
+		GetItemMesh()->SetMaterial(PreviousMaterialIndex, nullptr);
+		SetMaterialIndex(WeaponRow->MaterialIndex);
+
+		WeaponMagBoneName = WeaponRow->WeaponMagBoneName;
+		ReloadMontageSectionName = WeaponRow->ReloadMontageSectionName;
+
+		// In game the assets are streamed in by UpdateAssetRequest unless they are already resident
+		// Editor construction only previews them, anything set on the weapon itself would be saved with the map
+		const bool bIsGameWorld{ GetWorld() && GetWorld()->IsGameWorld() };
+		if (bIsGameWorld && DataSubsystem->AreWeaponAssetsLoaded(WeaponType))
+		{
+			ApplyWeaponAssets(*WeaponRow);
+		}
+		else
 		{
-		case EWeaponType::EWT_AR15:
-			WeaponRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName(TEXT("AR15")), TEXT(""));
-			break;
-		case EWeaponType::EWT_AssaultRifle:
-			WeaponRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName(TEXT("AssaultRifle")), TEXT(""));
-			break;
-		case EWeaponType::EWT_Pistol:
-			WeaponRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName(TEXT("Pistol")), TEXT(""));
-			break;
+			ClearWeaponAssets();
 		}
 
-		if (WeaponRow)
+#if WITH_EDITOR
+		if (!bIsGameWorld)
 		{
-			AmmoType = WeaponRow->AmmoType;
-			AmmoInMagazine = WeaponRow->WeaponAmmo;
-			MaximumMagazineCapacity = WeaponRow->MagazineCapacity;
-			SetPickupSound(WeaponRow->PickupSound);
-			SetEquipSound(WeaponRow->EquipSound);
-			SetItemImage(WeaponRow->WeaponInventoryIcon);
-			GetItemMesh()->SetSkeletalMesh(WeaponRow->WeaponMesh);
-			SetItemTypeString(WeaponRow->WeaponName);
-			SetAmmoImage(WeaponRow->WeaponAmmoInventoryIcon);
-			SetMaterialInstance(WeaponRow->MaterialInstance);
-
-			PreviousMaterialIndex = GetMaterialIndex();
-			GetItemMesh()->SetMaterial(PreviousMaterialIndex, nullptr);
-			SetMaterialIndex(WeaponRow->MaterialIndex);
-
-			WeaponMagBoneName = WeaponRow->WeaponMagBoneName;
-			ReloadMontageSectionName = WeaponRow->ReloadMontageSectionName;
-
-			GetItemMesh()->SetAnimInstanceClass(WeaponRow->AnimBP);
-
-			CrosshairMiddle = WeaponRow->CrosshairMiddle;
-			CrosshairLeft = WeaponRow->CrosshairLeft;
-			CrosshairRight = WeaponRow->CrosshairRight;
-			CrosshairTop = WeaponRow->CrosshairTop;
-			CrosshairBottom = WeaponRow->CrosshairBottom;
-
-			AutomaticFireRate = WeaponRow->AutomaticFireRate;
-			MuzzleFlash = WeaponRow->MuzzleFlash;
-			FireSound = WeaponRow->FireSound;
-
-			bIsAutomatic = WeaponRow->bIsAutomatic;
+			UpdateEditorPreview(*WeaponRow);
 		}
+#endif
+	}
+}
+
+#if WITH_EDITOR
+void AWeapon::UpdateEditorPreview(const FWeaponDataTable& WeaponRow)
+{
+	if (EditorPreviewMesh == nullptr || EditorPreviewMesh->IsPendingKill())
+	{
+		EditorPreviewMesh = NewObject<USkeletalMeshComponent>(this, NAME_None, RF_Transient | RF_DuplicateTransient | RF_TextExportTransient);
+		EditorPreviewMesh->bIsEditorOnly = true;
+		EditorPreviewMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		EditorPreviewMesh->SetCanEverAffectNavigation(false);
+		EditorPreviewMesh->SetupAttachment(GetRootComponent());
+		EditorPreviewMesh->RegisterComponent();
+	}
+
+	EditorPreviewMesh->SetSkeletalMesh(WeaponRow.WeaponMesh.LoadSynchronous());
+	EditorPreviewMesh->EmptyOverrideMaterials();
+	EditorPreviewMesh->SetMaterial(WeaponRow.MaterialIndex, WeaponRow.MaterialInstance.LoadSynchronous());
+}
+#endif
 
-		// The glow material is set on the item version but it needs to be overrided since we need different materials for each weapon
-		if (GetMaterialInstance())
+UStaticMesh* AWeapon::GetPickupProxyMesh() const
+{
+	const UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+
+	// Streamed in with the weapon's assets (the weapon is still in relevance range when it is stowed), then kept by the proxy component
+	// Not resident yet means the weapon stays an actor until a later store update
+	return DataSubsystem ? Cast<UStaticMesh>(DataSubsystem->GetWeaponProxyMeshPath(WeaponType).ResolveObject()) : nullptr;
+}
+
+void AWeapon::WritePickupRecord(FPickupRecord& Record) const
+{
+	Super::WritePickupRecord(Record);
+	Record.WeaponType = WeaponType;
+	Record.AmmoCount = AmmoInMagazine;
+}
+
+void AWeapon::ReadPickupRecord(const FPickupRecord& Record)
+{
+	WeaponType = Record.WeaponType;
+	Super::ReadPickupRecord(Record);
+
+	// Construction filled the magazine from the weapon row
+	AmmoInMagazine = Record.AmmoCount;
+}
+
+void AWeapon::UpdateStats()
+{
+	const UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+	Stats = DataSubsystem ? &DataSubsystem->GetWeaponStats(WeaponType) : &FWeaponStatBlock::GetDefault(WeaponType);
+
+	// Mirrored for Blueprints and the details panel, C++ reads the stat block
+	AmmoType = Stats->AmmoType;
+	MaximumMagazineCapacity = Stats->MagazineCapacity;
+	AutomaticFireRate = Stats->FireInterval;
+	bIsAutomatic = Stats->bIsAutomatic;
+	PelletCount = Stats->PelletCount;
+	PelletSpreadAngle = Stats->PelletSpreadAngle;
+	bCanPenetrate = Stats->bCanPenetrate;
+	bFiresProjectiles = Stats->bFiresProjectiles;
+	ProjectileSpeed = Stats->ProjectileSpeed;
+	ProjectileGravityScale = Stats->ProjectileGravityScale;
+	ProjectileLifetime = Stats->ProjectileLifetime;
+}
+
+void AWeapon::ApplySignificance()
+{
+	UpdateAssetRequest();
+	Super::ApplySignificance();
+}
+
+void AWeapon::ApplyWeaponAssets(const FWeaponDataTable& WeaponRow)
+{
+	SetPickupSound(WeaponRow.PickupSound.Get());
+	SetEquipSound(WeaponRow.EquipSound.Get());
+	SetItemImage(WeaponRow.WeaponInventoryIcon.Get());
+	SetAmmoImage(WeaponRow.WeaponAmmoInventoryIcon.Get());
+	GetItemMesh()->SetSkeletalMesh(WeaponRow.WeaponMesh.Get());
+	GetItemMesh()->SetAnimInstanceClass(WeaponRow.AnimBP.Get());
+	SetMaterialInstance(WeaponRow.MaterialInstance.Get());
+
+	CrosshairMiddle = WeaponRow.CrosshairMiddle.Get();
+	CrosshairLeft = WeaponRow.CrosshairLeft.Get();
+	CrosshairRight = WeaponRow.CrosshairRight.Get();
+	CrosshairTop = WeaponRow.CrosshairTop.Get();
+	CrosshairBottom = WeaponRow.CrosshairBottom.Get();
+
+	MuzzleFlash = WeaponRow.MuzzleFlash.Get();
+	FireSound = WeaponRow.FireSound.Get();
+
+	// The glow material is set on the item version but it needs to be overrided since we need different materials for each weapon
+	UpdateGlowMaterial();
+
+	GetItemMesh()->SetHiddenInGame(false);
+	bWeaponAssetsApplied = true;
+
+	// A weapon promoted from a pickup record takes over from its proxy instance now that it can be drawn
+	if (UPickupStoreSubsystem* PickupStore = GetWorld() ? GetWorld()->GetSubsystem<UPickupStoreSubsystem>() : nullptr)
+	{
+		PickupStore->OnItemReady(this);
+	}
+}
+
+void AWeapon::ClearWeaponAssets()
+{
+	// Nothing to show until the assets are back
+	GetItemMesh()->SetHiddenInGame(true);
+
+	SetPickupSound(nullptr);
+	SetEquipSound(nullptr);
+	SetItemImage(nullptr);
+	SetAmmoImage(nullptr);
+	GetItemMesh()->SetSkeletalMesh(nullptr);
+	GetItemMesh()->SetAnimInstanceClass(nullptr);
+	SetMaterialInstance(nullptr);
+	GetItemMesh()->SetMaterial(GetMaterialIndex(), nullptr);
+	SetDynamicMaterialInstance(nullptr);
+
+	CrosshairMiddle = nullptr;
+	CrosshairLeft = nullptr;
+	CrosshairRight = nullptr;
+	CrosshairTop = nullptr;
+	CrosshairBottom = nullptr;
+
+	MuzzleFlash = nullptr;
+	FireSound = nullptr;
+
+	bWeaponAssetsApplied = false;
+}
+
+void AWeapon::UpdateAssetRequest()
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr || !World->IsGameWorld()) return;
+
+	UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+	if (DataSubsystem == nullptr) return;
+
+	// Owned, falling and interping weapons always hold their assets, pickups only while a player is in relevance range
+	const bool bWantsAssets{ GetItemState() != EItemState::EIS_Pickup || GetInRelevanceRange() };
+	if (bWantsAssets != bHoldsAssetRequest)
+	{
+		bHoldsAssetRequest = bWantsAssets;
+		if (bWantsAssets)
 		{
-			// Construct dynamic material instance based on material instance
-			SetDynamicMaterialInstance(UMaterialInstanceDynamic::Create(GetMaterialInstance(), this));
-			GetDynamicMaterialInstance()->SetVectorParameterValue(FName(TEXT("FresnelColor")), GetGlowColor());
-
-			// Set the dynamic material instance to the mesh 
-			GetItemMesh()->SetMaterial(GetMaterialIndex(), GetDynamicMaterialInstance());
-			
-			// Turn on the glow material
-			EnableGlowMaterial();
+			DataSubsystem->RequestWeaponAssets(WeaponType, FSimpleDelegate::CreateUObject(this, &AWeapon::OnWeaponAssetsLoaded));
 		}
+		else
+		{
+			DataSubsystem->ReleaseWeaponAssets(WeaponType, this);
+		}
+	}
+
+	// Let go of the assets (including ones that were resident at construction) so they can be unloaded
+	if (!bWantsAssets && bWeaponAssetsApplied)
+	{
+		ClearWeaponAssets();
 	}
 }
 
+void AWeapon::OnWeaponAssetsLoaded()
+{
+	if (!bHoldsAssetRequest || bWeaponAssetsApplied) return;
+
+	const UShooterDataSubsystem* DataSubsystem = UShooterDataSubsystem::Get(this);
+	const FWeaponDataTable* WeaponRow = DataSubsystem ? DataSubsystem->GetWeaponRow(WeaponType) : nullptr;
+	if (WeaponRow)
+	{
+		ApplyWeaponAssets(*WeaponRow);
+
+		// The interp pulse needs the glow material that was just set
+		Super::ApplySignificance();
+	}
+}
 
 void AWeapon::DecrementAmmo()
 {
@@ -160,9 +393,9 @@ void AWeapon::DecrementAmmo()
 
 void AWeapon::UpdateAmmo(int32 Amount)
 {
-	if (AmmoInMagazine + Amount >= MaximumMagazineCapacity)
+	if (AmmoInMagazine + Amount >= Stats->MagazineCapacity)
 	{
-		AmmoInMagazine = MaximumMagazineCapacity;
+		AmmoInMagazine = Stats->MagazineCapacity;
 	}
 	else
 	{
@@ -173,28 +406,48 @@ void AWeapon::UpdateAmmo(int32 Amount)
 
 bool AWeapon::ClipIsFull()
 {
-	return AmmoInMagazine >= MaximumMagazineCapacity;
+	return AmmoInMagazine >= Stats->MagazineCapacity;
 }
 
 void AWeapon::StartPistolSlideTimer()
 {
 	bPistolSlideMoving = true;
-	GetWorldTimerManager().SetTimer(PistolSlideTimer, this, &AWeapon::FinishPistolSlideTimer, PistolSlideDuration);
+	PistolSlideElapsed = 0.f;
+	PreviousPistolSlideCurveValue = 0.f;
+	PistolSlideCurveValue = 0.f;
+	UpdateMotionRegistration();
 }
 
 void AWeapon::FinishPistolSlideTimer()
 {
 	bPistolSlideMoving = false;
+
+	// Slide is back in place (the last step may have sampled the curve just before the end)
+	PistolSlideCurveValue = 0.f;
+	PistolSlideDisplacement = 0.f;
+	PistolRecoilRotation = 0.f;
+	UpdateMotionRegistration();
 }
 
-void AWeapon::UpdateSlideDisplacement()
+void AWeapon::UpdateSlideDisplacement(int32 NumSteps, float StepTime, float Alpha)
 {
-	if (PistolSlideDisplacementCurve && bPistolSlideMoving)
+	if (!bPistolSlideMoving) return;
+
+	for (int32 Step = 0; Step < NumSteps; Step++)
 	{
-		const float ElapsedTime{ GetWorldTimerManager().GetTimerElapsed(PistolSlideTimer) };
-		const float CurveValue{ PistolSlideDisplacementCurve->GetFloatValue(ElapsedTime) };
-		PistolSlideDisplacement = CurveValue * MaxPistolSlideDisplacement;
-		PistolRecoilRotation = CurveValue * MaxPistolRecoilRotation;
+		PistolSlideElapsed += StepTime;
+		if (PistolSlideElapsed >= PistolSlideDuration)
+		{
+			FinishPistolSlideTimer();
+			return;
+		}
+
+		PreviousPistolSlideCurveValue = PistolSlideCurveValue;
+		PistolSlideCurveValue = PistolSlideDisplacementCurve ? PistolSlideDisplacementCurve->GetFloatValue(PistolSlideElapsed) : 0.f;
 	}
+
+	const float CurveValue{ FMath::Lerp(PreviousPistolSlideCurveValue, PistolSlideCurveValue, Alpha) };
+	PistolSlideDisplacement = CurveValue * MaxPistolSlideDisplacement;
+	PistolRecoilRotation = CurveValue * MaxPistolRecoilRotation;
 }
 
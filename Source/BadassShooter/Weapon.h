@@ -7,6 +7,7 @@
 #include "AmmoType.h"
 #include "Engine/DataTable.h"
 #include "WeaponType.h"
+#include "WeaponStatBlock.h"
 #include "Weapon.generated.h"
 
 
@@ -15,6 +16,9 @@ struct FWeaponDataTable : public FTableRowBase
 {
 	GENERATED_BODY()
 
+	/* Paths of every asset column (meshes, sounds, textures, FX and the AnimBP are soft references, streamed in by UShooterDataSubsystem) */
+	void GetAssetPaths(TArray<FSoftObjectPath>& OutPaths) const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	EAmmoType AmmoType;
 
@@ -25,25 +29,25 @@ struct FWeaponDataTable : public FTableRowBase
 	int32 MagazineCapacity;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	class USoundCue* PickupSound;
+	TSoftObjectPtr<class USoundCue> PickupSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USoundCue* EquipSound;
+	TSoftObjectPtr<USoundCue> EquipSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USkeletalMesh* WeaponMesh;
+	TSoftObjectPtr<USkeletalMesh> WeaponMesh;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FString WeaponName;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* WeaponInventoryIcon;
+	TSoftObjectPtr<UTexture2D> WeaponInventoryIcon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* WeaponAmmoInventoryIcon;
+	TSoftObjectPtr<UTexture2D> WeaponAmmoInventoryIcon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UMaterialInstance* MaterialInstance;
+	TSoftObjectPtr<UMaterialInstance> MaterialInstance;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 MaterialIndex;
@@ -55,34 +59,69 @@ struct FWeaponDataTable : public FTableRowBase
 	FName ReloadMontageSectionName;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	TSubclassOf<UAnimInstance> AnimBP;
+	TSoftClassPtr<UAnimInstance> AnimBP;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairMiddle;
+	TSoftObjectPtr<UTexture2D> CrosshairMiddle;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairLeft;
+	TSoftObjectPtr<UTexture2D> CrosshairLeft;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairRight;
+	TSoftObjectPtr<UTexture2D> CrosshairRight;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairTop;
+	TSoftObjectPtr<UTexture2D> CrosshairTop;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairBottom;
+	TSoftObjectPtr<UTexture2D> CrosshairBottom;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float AutomaticFireRate;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UParticleSystem* MuzzleFlash;
+	TSoftObjectPtr<UParticleSystem> MuzzleFlash;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USoundCue* FireSound;
+	TSoftObjectPtr<USoundCue> FireSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bIsAutomatic;
+
+	/* Number of pellets fired per shot (1 for regular hitscan weapons) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 PelletCount = 1;
+
+	/* Half angle in degrees of the cone the pellets spread in */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float PelletSpreadAngle = 0.f;
+
+	/* True if bullets can pass through thin surfaces (see SurfacePenetrationDepth on the character) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bCanPenetrate = false;
+
+	/* True if the weapon fires simulated projectiles (travel time and drop) instead of hitscan bullets */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	bool bFiresProjectiles = false;
+
+	/* Muzzle velocity of projectiles in cm/s */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ProjectileSpeed = 40000.f;
+
+	/* Multiplier for world gravity applied to projectiles (bullet drop) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ProjectileGravityScale = 1.f;
+
+	/* Seconds a projectile stays in flight before it is removed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ProjectileLifetime = 3.f;
+
+	/*
+	* Static mesh drawn (instanced) while a pickup of this weapon lies far from every player
+	* Streamed in with the weapon's other assets, UShooterDataSubsystem::FallbackWeaponProxyMeshPath is drawn when it is empty
+	*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSoftObjectPtr<class UStaticMesh> PickupProxyMesh;
 };
 
 /**
@@ -95,16 +134,46 @@ class BADASSSHOOTER_API AWeapon : public AItem
 
 public:
 	AWeapon();
-	void Tick(float DeltaTime);
 
 protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/* Points Stats at the weapon type's stat block */
+	void UpdateStats();
+
 	void StopFalling();
 
 	virtual void OnConstruction(const FTransform& Transform) override;
 
 	void FinishPistolSlideTimer();
 
-	void UpdateSlideDisplacement();
+	/* Advances the slide by the combat steps that are due and interpolates the displayed slide between the last two steps */
+	void UpdateSlideDisplacement(int32 NumSteps, float StepTime, float Alpha);
+
+	/* Adds the weapon to the motion subsystem while it falls or its slide moves and removes it once both are done */
+	void UpdateMotionRegistration();
+
+	/* Also requests or releases the weapon's streamed assets */
+	virtual void ApplySignificance() override;
+
+	/* Sets the mesh, materials, sounds, icons and FX of the weapon from its row (only assets that are resident are used) */
+	void ApplyWeaponAssets(const FWeaponDataTable& WeaponRow);
+
+	/* Drops every streamed asset reference and hides the mesh until the assets are requested again */
+	void ClearWeaponAssets();
+
+	/* Holds the weapon type's assets while the weapon is owned or a pickup in relevance range (significance above Low) */
+	void UpdateAssetRequest();
+
+	/* Assets-ready callback from UShooterDataSubsystem */
+	void OnWeaponAssetsLoaded();
+
+#if WITH_EDITOR
+	/* Editor worlds: shows the row's mesh and material on EditorPreviewMesh so placed weapons save no references to their assets */
+	void UpdateEditorPreview(const FWeaponDataTable& WeaponRow);
+#endif
 
 private:
 	FTimerHandle ThrowWeaponTimer;
@@ -180,6 +249,21 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
 	USoundCue* FireSound;
 
+	/* Combat stats of the weapon type, shared by every weapon of that type (never null) */
+	const FWeaponStatBlock* Stats;
+
+	/* True while this weapon holds a request for its weapon type's assets */
+	bool bHoldsAssetRequest;
+
+	/* True once the streamed assets are set on the weapon (the mesh is hidden in game until then) */
+	bool bWeaponAssetsApplied;
+
+#if WITH_EDITORONLY_DATA
+	/* Transient component drawing the weapon in editor worlds, never saved with the map or duplicated into PIE */
+	UPROPERTY(Transient, DuplicateTransient, TextExportTransient)
+	class USkeletalMeshComponent* EditorPreviewMesh;
+#endif
+
 	/* The amount the slide has displaced when firing the pistol */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Pistol, meta = (AllowPrivateAccess = "true"))
 	float PistolSlideDisplacement;
@@ -191,7 +275,12 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pistol, meta = (AllowPrivateAccess = "true"))
 	UCurveFloat* PistolSlideDisplacementCurve;
 
-	FTimerHandle PistolSlideTimer;
+	/* Time since the slide started moving, advanced in combat steps */
+	float PistolSlideElapsed;
+
+	/* Slide curve value at the last two combat steps */
+	float PreviousPistolSlideCurveValue;
+	float PistolSlideCurveValue;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Pistol, meta = (AllowPrivateAccess = "true"))
 	float PistolSlideDuration;
@@ -209,19 +298,46 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Weapon Properties", meta = (AllowPrivateAccess = "true"))
 	bool bIsAutomatic;
 
+	/* Number of pellets fired per shot (shotguns fire more than one) */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	int32 PelletCount;
+
+	/* Half angle in degrees of the pellet spread cone */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	float PelletSpreadAngle;
+
+	/* True if bullets from this weapon can pass through thin surfaces */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	bool bCanPenetrate;
+
+	/* True if this weapon fires projectiles (see UProjectileSubsystem) instead of hitscan bullets */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	bool bFiresProjectiles;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	float ProjectileSpeed;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	float ProjectileGravityScale;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = DataTable, meta = (AllowPrivateAccess = "true"))
+	float ProjectileLifetime;
 
 public:
 	void ThrowWeapon();
 
 	/* Function to return ammo in magazine (called in shooter character class) */
 	FORCEINLINE int32 GetAmmoInMagazine() const { return AmmoInMagazine; }
-	FORCEINLINE int32 GetMaximumMagazineCapacity() const { return MaximumMagazineCapacity; }
+	FORCEINLINE int32 GetMaximumMagazineCapacity() const { return Stats->MagazineCapacity; }
 
 	/* Decrement ammo in magazine after firing (called in shooter character class) */
 	void DecrementAmmo();
 
 	FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
-	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
+
+	/* Stat block read by the fire and reload code (one cache line) */
+	FORCEINLINE const FWeaponStatBlock& GetStats() const { return *Stats; }
+	FORCEINLINE EAmmoType GetAmmoType() const { return Stats->AmmoType; }
 	FORCEINLINE FName GetReloadMontageSectionName() const { return ReloadMontageSectionName; }
 	FORCEINLINE FName GetWeaponMagBoneName() const { return WeaponMagBoneName; }
 
@@ -230,12 +346,33 @@ public:
 
 	bool ClipIsFull();
 
-	FORCEINLINE float GetAutomaticFireRate() const { return AutomaticFireRate; }
+	FORCEINLINE float GetAutomaticFireRate() const { return Stats->FireInterval; }
 	FORCEINLINE UParticleSystem* GetMuzzleFlash() const { return MuzzleFlash; }
 	FORCEINLINE USoundCue* GetFireSound() const { return FireSound; }
 
 	void StartPistolSlideTimer();
 
-	FORCEINLINE bool GetIsAutomatic() const { return bIsAutomatic; }
+	/*
+	* Keeps a falling weapon upright and moves the pistol slide (called by UWeaponMotionSubsystem)
+	* @param NumSteps: Combat steps due this frame
+	* @param StepTime: Length of one combat step
+	* @param Alpha: How far the frame is between the last step and the next one
+	*/
+	void UpdateMotion(int32 NumSteps, float StepTime, float Alpha);
+
+	FORCEINLINE bool GetIsAutomatic() const { return Stats->bIsAutomatic; }
+	FORCEINLINE int32 GetPelletCount() const { return Stats->PelletCount; }
+	FORCEINLINE float GetPelletSpreadAngle() const { return Stats->PelletSpreadAngle; }
+	FORCEINLINE bool GetCanPenetrate() const { return Stats->bCanPenetrate; }
+	FORCEINLINE bool GetFiresProjectiles() const { return Stats->bFiresProjectiles; }
+	FORCEINLINE float GetProjectileSpeed() const { return Stats->ProjectileSpeed; }
+	FORCEINLINE float GetProjectileGravityScale() const { return Stats->ProjectileGravityScale; }
+	FORCEINLINE float GetProjectileLifetime() const { return Stats->ProjectileLifetime; }
+
+	/* Pickup store hooks (weapon type and ammo in the magazine are part of the record) */
+	virtual UStaticMesh* GetPickupProxyMesh() const override;
+	virtual bool IsPickupReady() const override { return bWeaponAssetsApplied; }
+	virtual void WritePickupRecord(FPickupRecord& Record) const override;
+	virtual void ReadPickupRecord(const FPickupRecord& Record) override;
 	
 };
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponMotionSubsystem.h"
+#include "Weapon.h"
+#include "FixedStepClock.h"
+#include "Engine/World.h"
+
+UWeaponMotionSubsystem::UWeaponMotionSubsystem()
+{
+	// After physics so falling weapons are kept upright on this frame's results and before the held weapon mesh animates in TG_PostUpdateWork
+	TickFunction.TickGroup = TG_PostPhysics;
+}
+
+void UWeaponMotionSubsystem::AddWeapon(AWeapon* Weapon)
+{
+	MovingWeapons.AddUnique(Weapon);
+	SetTickEnabled(true);
+}
+
+void UWeaponMotionSubsystem::RemoveWeapon(AWeapon* Weapon)
+{
+	MovingWeapons.RemoveSwap(Weapon);
+	SetTickEnabled(MovingWeapons.Num() > 0);
+}
+
+void UWeaponMotionSubsystem::Tick(float DeltaTime)
+{
+	// Same steps as the characters simulated earlier this frame
+	const FFixedStepClock& CombatClock = GetWorld()->GetSubsystem<UCombatClockSubsystem>()->GetClock();
+	const int32 NumSteps{ CombatClock.GetNumSteps() };
+	const float StepTime{ CombatClock.GetStepTime() };
+	const float Alpha{ CombatClock.GetAlpha() };
+
+	// Back to front, a weapon that stops moving removes itself during its update
+	for (int32 Index = MovingWeapons.Num() - 1; Index >= 0; --Index)
+	{
+		if (AWeapon* Weapon = MovingWeapons[Index])
+		{
+			Weapon->UpdateMotion(NumSteps, StepTime, Alpha);
+		}
+	}
+}
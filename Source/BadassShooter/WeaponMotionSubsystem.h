@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ShooterTickSubsystem.h"
+#include "WeaponMotionSubsystem.generated.h"
+
+/**
+ * Updates the weapons that are moving (falling weapons kept upright and pistols mid-slide) in one loop
+ * Weapons are only in here while they move, so the cost scales with active weapons and not spawned weapons
+ * The pistol slide runs on the world's combat clock (UCombatClockSubsystem) so it plays out the same at any frame rate
+ */
+UCLASS()
+class BADASSSHOOTER_API UWeaponMotionSubsystem : public UShooterTickSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UWeaponMotionSubsystem();
+
+	void AddWeapon(class AWeapon* Weapon);
+	void RemoveWeapon(AWeapon* Weapon);
+
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	/* Weapons that currently need motion updates */
+	UPROPERTY()
+	TArray<AWeapon*> MovingWeapons;
+};
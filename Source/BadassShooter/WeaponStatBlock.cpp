@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponStatBlock.h"
+
+namespace
+{
+	/* Indexed by EWeaponType, UShooterDataSubsystem warns when the weapon data table no longer matches these */
+	constexpr FWeaponStatBlock DefaultBlocks[] = {
+		{ EWeaponType::EWT_AR15, EAmmoType::EAT_AR, 0.1f, 30, true },
+		{ EWeaponType::EWT_AssaultRifle, EAmmoType::EAT_AR, 0.1f, 30, true },
+		{ EWeaponType::EWT_Pistol, EAmmoType::EAT_Pistol, 0.2f, 12, false },
+	};
+
+	static_assert(UE_ARRAY_COUNT(DefaultBlocks) == static_cast<SIZE_T>(EWeaponType::EWT_MAX), "Every weapon type needs a default stat block");
+}
+
+const FWeaponStatBlock& FWeaponStatBlock::GetDefault(EWeaponType WeaponType)
+{
+	const SIZE_T Index{ static_cast<SIZE_T>(WeaponType) };
+	return DefaultBlocks[Index < UE_ARRAY_COUNT(DefaultBlocks) ? Index : 0];
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AmmoType.h"
+#include "WeaponType.h"
+
+/*
+* Combat stats of one weapon type packed into a single cache line
+* Fire, reload and ammo code read these instead of the per actor copies on AWeapon, which sit between dozens of asset pointers
+* UShooterDataSubsystem builds one block per EWeaponType from the weapon data table when it loads, GetDefault is used for rows that are missing
+*/
+struct alignas(PLATFORM_CACHE_LINE_SIZE) FWeaponStatBlock
+{
+	/* Seconds between shots (AutomaticFireRate in the table) */
+	float FireInterval{ 0.1f };
+	float PelletSpreadAngle{ 0.f };
+	float ProjectileSpeed{ 40'000.f };
+	float ProjectileGravityScale{ 1.f };
+	float ProjectileLifetime{ 3.f };
+	int32 MagazineCapacity{ 30 };
+	int32 PelletCount{ 1 };
+	EWeaponType WeaponType{ EWeaponType::EWT_AssaultRifle };
+	EAmmoType AmmoType{ EAmmoType::EAT_AR };
+	bool bIsAutomatic{ true };
+	bool bCanPenetrate{ false };
+	bool bFiresProjectiles{ false };
+
+	constexpr FWeaponStatBlock() = default;
+
+	constexpr FWeaponStatBlock(EWeaponType InWeaponType, EAmmoType InAmmoType, float InFireInterval, int32 InMagazineCapacity, bool bInIsAutomatic) :
+		FireInterval(InFireInterval),
+		MagazineCapacity(InMagazineCapacity),
+		WeaponType(InWeaponType),
+		AmmoType(InAmmoType),
+		bIsAutomatic(bInIsAutomatic)
+	{
+	}
+
+	/* Stats of a weapon type from its data table row */
+	static FWeaponStatBlock FromRow(EWeaponType WeaponType, const struct FWeaponDataTable& WeaponRow);
+
+	/* Built in stats of the shipped weapons */
+	static const FWeaponStatBlock& GetDefault(EWeaponType WeaponType);
+};
+
+static_assert(sizeof(FWeaponStatBlock) == PLATFORM_CACHE_LINE_SIZE, "FWeaponStatBlock should fill exactly one cache line");